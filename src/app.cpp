@@ -19,6 +19,13 @@
 #include "app.h"
 #include "drivers/adc.h"
 #include "settings.h"
+#include "event.h"
+#include "params.h"
+#include "fault_log.h"
+#include "energy.h"
+#include "protection.h"
+#include "thermal.h"
+#include "setpoint.h"
 #include "drivers/pwm.h"
 #include "modes/calibration_mode.h"
 #include "modes/idle_mode.h"
@@ -27,6 +34,7 @@
 #include "modes/mppt_mode.h"
 #include "modes/error_mode.h"
 #include "modes/charge_mode.h"
+#include "modes/list_mode.h"
 #include "drivers/button.h"
 #include "drivers/led.h"
 
@@ -36,21 +44,118 @@ Application_t gApp;
 // Local functions
 static void take_measurements();
 static void protect();
+static void protect_10ms();
+static void protect_100ms();
+static void update_duty_ceiling();
+static void stats_10ms();
+static void stats_1000ms();
+static void stats_reset();
 static bool enter_calibration_mode();
+
+// Output statistics window
+static AppStats_t stats;
+// Time in 10ms the duty cycle sits at its ceiling without output voltage
+static uint8_t noOutput10ms;
+
+/// @brief Print telemetry in "name=value" format on a single line
+void APP_PrintTelemetry()
+{
+  Serial.print(F("mode="));
+  Serial.print(gSettings.mode);
+  Serial.print(F(" state="));
+  Serial.print(APP_ModeState());
+  Serial.print(F(" out="));
+  Serial.print(gSettings.output);
+  Serial.print(F(" step="));
+  Serial.print(LIST_MODE_Step());
+  Serial.print(F(" duty="));
+  Serial.print(gApp.duty_cycle);
+  Serial.print(F(" ceiling="));
+  Serial.print(gApp.duty_ceiling);
+  Serial.print(F(" vin="));
+  Serial.print(gApp.input_voltage);
+  Serial.print(F(" iin="));
+  Serial.print(gApp.input_current);
+  Serial.print(F(" vout="));
+  Serial.print(gApp.output_voltage);
+  Serial.print(F(" iout="));
+  Serial.print(gApp.output_current);
+  Serial.print(F(" ocv="));
+  Serial.print(CHARGE_MODE_OpenCircuitVoltage());
+  Serial.print(F(" ir="));
+  Serial.print(CHARGE_MODE_Resistance());
+  Serial.print(F(" temp="));
+  Serial.print(gApp.temperature);
+  Serial.print(F(" derating="));
+  Serial.print(gApp.derating);
+  Serial.print(F(" eff="));
+  Serial.print(gApp.efficiency);
+  Serial.print(F(" ripple="));
+  Serial.print(gApp.output_ripple);
+  Serial.print(F(" burst="));
+  Serial.print(PWM_BurstActive());
+  Serial.print(F(" bursts="));
+  Serial.print(PWM_BurstCount());
+  Serial.print(F(" mah="));
+  Serial.print(ENERGY_Charge());
+  Serial.print(F(" mwh="));
+  Serial.print(ENERGY_OutputEnergy());
+  Serial.print(F(" mwh_in="));
+  Serial.print(ENERGY_InputEnergy());
+  Serial.print(F(" energy_eff="));
+  Serial.println(ENERGY_Efficiency());
+}
+
 #ifdef DEBUG_MODE
 static void print_debug_info();
 #endif
 
+// Mode operations table, indexed by AppMode_t and AppModeOp_t
+static const AppModeOps_t modeOps[] PROGMEM = {
+    {IDLE_MODE_Init, IDLE_MODE_Tick, IDLE_MODE_TimeSlice10ms, IDLE_MODE_TimeSlice100ms, IDLE_MODE_TimeSlice500ms, IDLE_MODE_TimeSlice1000ms,
+     IDLE_MODE_ModeBtnPressed, IDLE_MODE_ModeBtnHeld, IDLE_MODE_OutputBtnPressed, IDLE_MODE_OutputBtnHeld}, // APP_MODE_IDLE
+    {CV_MODE_Init, CV_MODE_Tick, CV_MODE_TimeSlice10ms, CV_MODE_TimeSlice100ms, CV_MODE_TimeSlice500ms, CV_MODE_TimeSlice1000ms,
+     CV_MODE_ModeBtnPressed, CV_MODE_ModeBtnHeld, CV_MODE_OutputBtnPressed, CV_MODE_OutputBtnHeld}, // APP_MODE_CV
+    {CC_MODE_Init, CC_MODE_Tick, CC_MODE_TimeSlice10ms, CC_MODE_TimeSlice100ms, CC_MODE_TimeSlice500ms, CC_MODE_TimeSlice1000ms,
+     CC_MODE_ModeBtnPressed, CC_MODE_ModeBtnHeld, CC_MODE_OutputBtnPressed, CC_MODE_OutputBtnHeld}, // APP_MODE_CC
+    {CHARGE_MODE_Init, CHARGE_MODE_Tick, CHARGE_MODE_TimeSlice10ms, CHARGE_MODE_TimeSlice100ms, CHARGE_MODE_TimeSlice500ms, CHARGE_MODE_TimeSlice1000ms,
+     CHARGE_MODE_ModeBtnPressed, CHARGE_MODE_ModeBtnHeld, CHARGE_MODE_OutputBtnPressed, CHARGE_MODE_OutputBtnHeld}, // APP_MODE_CHARGE
+    {MPPT_MODE_Init, MPPT_MODE_Tick, MPPT_MODE_TimeSlice10ms, MPPT_MODE_TimeSlice100ms, MPPT_MODE_TimeSlice500ms, MPPT_MODE_TimeSlice1000ms,
+     MPPT_MODE_ModeBtnPressed, MPPT_MODE_ModeBtnHeld, MPPT_MODE_OutputBtnPressed, MPPT_MODE_OutputBtnHeld}, // APP_MODE_MPPT
+    {ERROR_MODE_Init, ERROR_MODE_Tick, ERROR_MODE_TimeSlice10ms, ERROR_MODE_TimeSlice100ms, ERROR_MODE_TimeSlice500ms, ERROR_MODE_TimeSlice1000ms,
+     ERROR_MODE_ModeBtnPressed, ERROR_MODE_ModeBtnHeld, ERROR_MODE_OutputBtnPressed, ERROR_MODE_OutputBtnHeld}, // APP_MODE_ERROR
+    {CALIBRATION_MODE_Init, CALIBRATION_MODE_Tick, CALIBRATION_MODE_TimeSlice10ms, CALIBRATION_MODE_TimeSlice100ms, CALIBRATION_MODE_TimeSlice500ms, CALIBRATION_MODE_TimeSlice1000ms,
+     CALIBRATION_MODE_ModeBtnPressed, CALIBRATION_MODE_ModeBtnHeld, CALIBRATION_MODE_OutputBtnPressed, CALIBRATION_MODE_OutputBtnHeld}, // APP_MODE_CALIBRATION
+    {LIST_MODE_Init, LIST_MODE_Tick, LIST_MODE_TimeSlice10ms, LIST_MODE_TimeSlice100ms, LIST_MODE_TimeSlice500ms, LIST_MODE_TimeSlice1000ms,
+     LIST_MODE_ModeBtnPressed, LIST_MODE_ModeBtnHeld, LIST_MODE_OutputBtnPressed, LIST_MODE_OutputBtnHeld}, // APP_MODE_LIST
+};
+// Every mode has to be registered
+static_assert(sizeof(modeOps) / sizeof(modeOps[0]) == APP_MODE_MAX, "modeOps must have a row for every AppMode_t");
+
 /// @brief Setup app
 void APP_Setup()
 {
   // Load settings
   SETTINGS_Load();
+  // Load tunable params
+  PARAMS_Load();
+  // Apply tunable PWM mode
+  PWM_SetMode(gParams.pwm.mode);
+  // Load fault log
+  FAULT_LOG_Setup();
+  // Load energy log
+  ENERGY_Setup();
+  // Load list mode program
+  LIST_MODE_Setup();
   gApp.duty_cycle = 0;
+  gApp.duty_ceiling = MAX_DUTY_CYCLE;
+  gApp.target_voltage = 0;
   gApp.input_voltage = 0;
   gApp.output_voltage = 0;
   gApp.input_current = 0;
   gApp.output_current = 0;
+  stats_reset();
+  THERMAL_Setup();
 
   if (enter_calibration_mode())
   {
@@ -66,33 +171,7 @@ void APP_Tick()
   take_measurements();
   protect();
 
-  switch (gSettings.mode)
-  {
-  case APP_MODE_IDLE:
-    IDLE_MODE_Tick();
-    break;
-  case APP_MODE_CV:
-    CV_MODE_Tick();
-    break;
-  case APP_MODE_CC:
-    CC_MODE_Tick();
-    break;
-  case APP_MODE_CHARGE:
-    CHARGE_MODE_Tick();
-    break;
-  case APP_MODE_MPPT:
-    MPPT_MODE_Tick();
-    break;
-  case APP_MODE_ERROR:
-    ERROR_MODE_Tick();
-    break;
-  case APP_MODE_CALIBRATION:
-    CALIBRATION_MODE_Tick();
-    break;
-  default:
-    ERROR_MODE_Tick();
-    break;
-  }
+  APP_Dispatch(APP_MODE_OP_TICK);
 
   // update hardware PWM output based on app values
   PWM_Tick();
@@ -100,123 +179,28 @@ void APP_Tick()
 
 void APP_TimeSlice10ms()
 {
-  switch (gSettings.mode)
-  {
-  case APP_MODE_IDLE:
-    IDLE_MODE_TimeSlice10ms();
-    break;
-  case APP_MODE_CV:
-    CV_MODE_TimeSlice10ms();
-    break;
-  case APP_MODE_CC:
-    CC_MODE_TimeSlice10ms();
-    break;
-  case APP_MODE_CHARGE:
-    CHARGE_MODE_TimeSlice10ms();
-    break;
-  case APP_MODE_MPPT:
-    MPPT_MODE_TimeSlice10ms();
-    break;
-  case APP_MODE_ERROR:
-    ERROR_MODE_TimeSlice10ms();
-    break;
-  case APP_MODE_CALIBRATION:
-    CALIBRATION_MODE_TimeSlice10ms();
-    break;
-  default:
-    ERROR_MODE_TimeSlice10ms();
-    break;
-  }
+  FAULT_LOG_TimeSlice10ms();
+  update_duty_ceiling();
+  protect_10ms();
+  stats_10ms();
+  ENERGY_TimeSlice10ms();
+
+  APP_Dispatch(APP_MODE_OP_TIME_SLICE_10MS);
 }
 void APP_TimeSlice100ms()
 {
-  switch (gSettings.mode)
-  {
-  case APP_MODE_IDLE:
-    IDLE_MODE_TimeSlice100ms();
-    break;
-  case APP_MODE_CV:
-    CV_MODE_TimeSlice100ms();
-    break;
-  case APP_MODE_CC:
-    CC_MODE_TimeSlice100ms();
-    break;
-  case APP_MODE_CHARGE:
-    CHARGE_MODE_TimeSlice100ms();
-    break;
-  case APP_MODE_MPPT:
-    MPPT_MODE_TimeSlice100ms();
-    break;
-  case APP_MODE_ERROR:
-    ERROR_MODE_TimeSlice100ms();
-    break;
-  case APP_MODE_CALIBRATION:
-    CALIBRATION_MODE_TimeSlice100ms();
-    break;
-  default:
-    ERROR_MODE_TimeSlice100ms();
-    break;
-  }
+  protect_100ms();
+
+  APP_Dispatch(APP_MODE_OP_TIME_SLICE_100MS);
 }
 void APP_TimeSlice500ms()
 {
-  switch (gSettings.mode)
-  {
-  case APP_MODE_IDLE:
-    IDLE_MODE_TimeSlice500ms();
-    break;
-  case APP_MODE_CV:
-    CV_MODE_TimeSlice500ms();
-    break;
-  case APP_MODE_CC:
-    CC_MODE_TimeSlice500ms();
-    break;
-  case APP_MODE_CHARGE:
-    CHARGE_MODE_TimeSlice500ms();
-    break;
-  case APP_MODE_MPPT:
-    MPPT_MODE_TimeSlice500ms();
-    break;
-  case APP_MODE_ERROR:
-    ERROR_MODE_TimeSlice500ms();
-    break;
-  case APP_MODE_CALIBRATION:
-    CALIBRATION_MODE_TimeSlice500ms();
-    break;
-  default:
-    ERROR_MODE_TimeSlice500ms();
-    break;
-  }
+  APP_Dispatch(APP_MODE_OP_TIME_SLICE_500MS);
 }
 void APP_TimeSlice1000ms()
 {
-  switch (gSettings.mode)
-  {
-  case APP_MODE_IDLE:
-    IDLE_MODE_TimeSlice1000ms();
-    break;
-  case APP_MODE_CV:
-    CV_MODE_TimeSlice1000ms();
-    break;
-  case APP_MODE_CC:
-    CC_MODE_TimeSlice1000ms();
-    break;
-  case APP_MODE_CHARGE:
-    CHARGE_MODE_TimeSlice1000ms();
-    break;
-  case APP_MODE_MPPT:
-    MPPT_MODE_TimeSlice1000ms();
-    break;
-  case APP_MODE_ERROR:
-    ERROR_MODE_TimeSlice1000ms();
-    break;
-  case APP_MODE_CALIBRATION:
-    CALIBRATION_MODE_TimeSlice1000ms();
-    break;
-  default:
-    ERROR_MODE_TimeSlice1000ms();
-    break;
-  }
+  stats_1000ms();
+  APP_Dispatch(APP_MODE_OP_TIME_SLICE_1000MS);
 
 #ifdef DEBUG_MODE
   print_debug_info();
@@ -228,33 +212,60 @@ void APP_InitCurrentApp()
 {
   // Clear any left-over LED state from previous app mode
   LED_Clear();
+  // regulator of the new mode sets its own target
+  gApp.target_voltage = 0;
+
+  APP_Dispatch(APP_MODE_OP_INIT);
+}
+
+/// @brief Call operation of the current mode, invalid modes are handled by error mode
+/// @param op mode operation
+void APP_Dispatch(AppModeOp_t op)
+{
+  uint8_t mode = (gSettings.mode < APP_MODE_MAX) ? gSettings.mode : APP_MODE_ERROR;
+  AppModeHandler_t handler = (AppModeHandler_t)pgm_read_ptr(&modeOps[mode][op]);
+
+  handler();
+}
 
+/// @brief Apply changed tunable params by restarting current app
+void APP_ReloadParams()
+{
+  PWM_SetMode(gParams.pwm.mode);
+  // calibration mode init would restart the whole calibration process
+  if (gSettings.mode != APP_MODE_CALIBRATION)
+  {
+    APP_InitCurrentApp();
+  }
+}
+
+/// @brief Enter error mode recording the fault
+/// @param cause fault cause
+void APP_Fault(FaultCause_t cause)
+{
+#ifdef DEBUG_MODE
+  print_debug_info();
+#endif
+  FAULT_LOG_Record(cause);
+  ERROR_MODE_Trip(cause);
+}
+
+/// @brief Get state machine state of the current app mode
+/// @return mode specific state (0 for modes without state machine)
+uint8_t APP_ModeState()
+{
   switch (gSettings.mode)
   {
-  case APP_MODE_IDLE:
-    IDLE_MODE_Init();
-    break;
   case APP_MODE_CV:
-    CV_MODE_Init();
-    break;
+    return CV_MODE_GetState();
   case APP_MODE_CC:
-    CC_MODE_Init();
-    break;
+    return CC_MODE_GetState();
   case APP_MODE_CHARGE:
-    CHARGE_MODE_Init();
-    break;
-  case APP_MODE_MPPT:
-    MPPT_MODE_Init();
-    break;
-  case APP_MODE_ERROR:
-    ERROR_MODE_Init();
-    break;
-  case APP_MODE_CALIBRATION:
-    CALIBRATION_MODE_Init();
-    break;
+    return CHARGE_MODE_GetState();
+  case APP_MODE_LIST:
+    return LIST_MODE_GetState();
   default:
-    ERROR_MODE_Init();
-    break;
+    return 0;
   }
 }
 
@@ -297,10 +308,7 @@ void APP_OutputOff()
   gSettings.output = 0;
   gApp.duty_cycle = 0;
   gSettingsSaveIn1000ms = SETTINGS_SAVE_DELAY_SECONDS;
-  // TODO: Add a countdown so if there is no activity after like 30seconds:
-  // turn off LEDs,
-  // attach wakup interrupt to MODE btn
-  // go to sleep
+  // note: power.cpp stops the converter and powers down after inactivity timeout
 }
 
 /// @brief Turn on output
@@ -330,6 +338,15 @@ static void print_debug_info()
 
   Serial.print("Output current [mA]: ");
   Serial.println(gApp.output_current);
+
+  Serial.print("Temperature [0.1C]: ");
+  Serial.println(gApp.temperature);
+
+  Serial.print("Derating [%]: ");
+  Serial.println(gApp.derating);
+
+  Serial.print("Dropped events: ");
+  Serial.println(EVENT_Dropped());
 }
 #endif
 
@@ -342,36 +359,91 @@ static void protect()
     return;
   }
 
-  // general input over-current, output over-current, output over-voltage protections
-  if (gApp.input_current > MAX_INPUT_CURRENT || gApp.output_current > MAX_OUTPUT_CURRENT || gApp.output_voltage > MAX_OUTPUT_VOLTAGE)
+  // general input over-current, output over-current, output over-voltage and
+  // SEPIC diode reverse voltage instantaneous (hard limit) protections
+  FaultCause_t cause = PROTECTION_Tick();
+  if (cause != FAULT_CAUSE_NONE)
   {
 #ifdef DEBUG_MODE
-    Serial.println(F("ERROR! Protection circuit triggered for below values:"));
-    print_debug_info();
+    Serial.print(F("ERROR! Hard limit protection triggered, cause: "));
+    Serial.println(cause);
 #endif
-    ERROR_MODE_Init();
+    APP_Fault(cause);
   }
+}
 
-  // detect broken mosfet or other physical fault when duty cycle is max, but there is no voltage output
-  if (gApp.duty_cycle == MAX_DUTY_CYCLE && gApp.output_voltage < MIN_OUTPUT_VOLTAGE)
+// Apply inverse-time protection rules for all modes
+static void protect_10ms()
+{
+  // accumulators keep cooling down in error mode
+  FaultCause_t cause = PROTECTION_TimeSlice10ms();
+
+  // guard clause
+  if (gSettings.mode == APP_MODE_ERROR)
+  {
+    return;
+  }
+
+  // over-current, over-voltage and reverse voltage excess across SEPIC diode protections
+  // note: voltage targets are admitted and clamped against the reverse voltage budget in setpoint.cpp,
+  // so this only trips if the input voltage alone exceeds it or the regulation fails to keep up
+  if (cause != FAULT_CAUSE_NONE)
   {
 #ifdef DEBUG_MODE
-    Serial.println(F("ERROR! Max duty cycle reached, but output voltage is below minimum."));
-    print_debug_info();
+    Serial.print(F("ERROR! Inverse-time protection triggered, cause: "));
+    Serial.println(cause);
 #endif
-    ERROR_MODE_Init();
+    APP_Fault(cause);
+    return;
+  }
+
+  // detect broken mosfet or other physical fault when duty cycle sits at its ceiling, but there is no voltage output
+  if (gApp.duty_cycle > MIN_DUTY_CYCLE && gApp.duty_cycle >= gApp.duty_ceiling && gApp.output_voltage < MIN_OUTPUT_VOLTAGE)
+  {
+    if (++noOutput10ms >= NO_OUTPUT_DETECT_10MS)
+    {
+#ifdef DEBUG_MODE
+      Serial.println(F("ERROR! Duty cycle ceiling reached, but output voltage is below minimum."));
+#endif
+      noOutput10ms = 0;
+      APP_Fault(FAULT_CAUSE_NO_OUTPUT);
+    }
+  }
+  else
+  {
+    noOutput10ms = 0;
+  }
+}
+
+// Recompute duty cycle ceiling for the operating point and pull the duty cycle down to it at once
+static void update_duty_ceiling()
+{
+  gApp.duty_ceiling = SETPOINT_DutyCeiling(gApp.duty_ceiling);
+  if (gApp.duty_cycle > gApp.duty_ceiling)
+  {
+    gApp.duty_cycle = gApp.duty_ceiling;
+  }
+}
+
+// Apply thermal protection for all modes
+static void protect_100ms()
+{
+  // temperature and derating keep updating in error mode
+  FaultCause_t cause = THERMAL_TimeSlice100ms();
+
+  // guard clause
+  if (gSettings.mode == APP_MODE_ERROR)
+  {
+    return;
   }
 
-  // detect reverse voltage excess across SEPIC diode to prevent the diode from failing short
-  // TODO: In the future also prevent user from selecting such combination of voltages
-  // note: user might get stuck in this error mode
-  if (gApp.input_voltage + gApp.output_voltage >= MAX_VIN_PLUS_VOUT)
+  if (cause != FAULT_CAUSE_NONE)
   {
 #ifdef DEBUG_MODE
-    Serial.println(F("ERROR! Vin+Vout is greater than diode max reverse voltage."));
-    print_debug_info();
+    Serial.print(F("ERROR! Over-temperature protection triggered, temperature: "));
+    Serial.println(gApp.temperature);
 #endif
-    ERROR_MODE_Init();
+    APP_Fault(cause);
   }
 }
 
@@ -384,6 +456,38 @@ static void take_measurements()
   gApp.output_voltage = ADC_OutputVoltageVal();
 }
 
+// Accumulate output statistics
+static void stats_10ms()
+{
+  stats.input_power += (gApp.input_voltage * gApp.input_current) / 1000;
+  stats.output_power += (gApp.output_voltage * gApp.output_current) / 1000;
+  if (gApp.output_voltage < stats.output_voltage_min)
+  {
+    stats.output_voltage_min = gApp.output_voltage;
+  }
+  if (gApp.output_voltage > stats.output_voltage_max)
+  {
+    stats.output_voltage_max = gApp.output_voltage;
+  }
+}
+
+// Publish efficiency and ripple of the last second
+static void stats_1000ms()
+{
+  gApp.efficiency = (stats.input_power > 0) ? (stats.output_power * 1000) / stats.input_power : 0;
+  gApp.output_ripple = (stats.output_voltage_max >= stats.output_voltage_min) ? stats.output_voltage_max - stats.output_voltage_min : 0;
+  stats_reset();
+}
+
+// Start new statistics window
+static void stats_reset()
+{
+  stats.input_power = 0;
+  stats.output_power = 0;
+  stats.output_voltage_min = UINT16_MAX;
+  stats.output_voltage_max = 0;
+}
+
 // Determine if calibration mode should be entered
 static bool enter_calibration_mode()
 {
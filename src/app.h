@@ -18,6 +18,7 @@
 #define APP_H
 
 #include "lib/util.h"
+#include "fault_log.h"
 
 // Max input current in mA
 #define MAX_INPUT_CURRENT TO_MILI(1.5)
@@ -31,6 +32,8 @@
 #define MAX_OUTPUT_VOLTAGE TO_MILI(16.9)
 // Minimum output voltage in mV when duty cycle is maximum (used to detect physical circuit faults)
 #define MIN_OUTPUT_VOLTAGE TO_MILI(1.0)
+// Time in 10ms the duty cycle must sit at its ceiling without output voltage to detect a physical circuit fault
+#define NO_OUTPUT_DETECT_10MS 10
 // Define SEPIC output diode max reverse voltage in mV, 40V for SS54
 #define DIODE_MAX_REVERSE_VOLTAGE TO_MILI(40.0)
 // The sum of Vin+Vout must be < diode max reverse voltage rating, otherwise it will fail short.
@@ -47,15 +50,52 @@
 typedef struct
 {
     uint8_t duty_cycle;      // current operating duty cycle of the converter
+    uint8_t duty_ceiling;    // max duty cycle useful at current operating point (<= MAX_DUTY_CYCLE)
+    uint32_t target_voltage; // output voltage target in mV of the active regulator (0 if none)
     uint32_t input_voltage;  // input voltage in mV
     uint32_t output_voltage; // output voltage in mV
     uint32_t input_current;  // input current in mA
     uint32_t output_current; // output current in mA
+    int16_t temperature;     // power stage temperature in 0.1°C (THERMAL_UNKNOWN if sensor is not fitted)
+    uint8_t derating;        // thermal derating of the output current limits (0-100%)
+    uint16_t efficiency;     // conversion efficiency in 0.1% averaged over last second
+    uint16_t output_ripple;  // peak-to-peak output voltage in mV over last second
 } Application_t;
 
+// Output statistics window, sampled every 10ms and published every second
+typedef struct
+{
+    uint32_t input_power;        // input power sum in mW
+    uint32_t output_power;       // output power sum in mW
+    uint16_t output_voltage_min; // min output voltage in mV
+    uint16_t output_voltage_max; // max output voltage in mV
+} AppStats_t;
+
 // Global app variable
 extern Application_t gApp;
 
+// Mode operations, each mode provides a handler for every operation
+enum AppModeOp_t : uint8_t
+{
+    APP_MODE_OP_INIT = 0,           // initialize mode
+    APP_MODE_OP_TICK,               // runs every tick
+    APP_MODE_OP_TIME_SLICE_10MS,    // runs every 10ms
+    APP_MODE_OP_TIME_SLICE_100MS,   // runs every 100ms
+    APP_MODE_OP_TIME_SLICE_500MS,   // runs every 500ms
+    APP_MODE_OP_TIME_SLICE_1000MS,  // runs every 1000ms
+    APP_MODE_OP_MODE_BTN_PRESSED,   // mode button short press
+    APP_MODE_OP_MODE_BTN_HELD,      // mode button long press
+    APP_MODE_OP_OUTPUT_BTN_PRESSED, // output button short press
+    APP_MODE_OP_OUTPUT_BTN_HELD,    // output button long press
+    APP_MODE_OP_MAX                 // not used, table size
+};
+typedef enum AppModeOp_t AppModeOp_t;
+
+// Mode operation handler
+typedef void (*AppModeHandler_t)();
+// Mode operations table row (stored in flash)
+typedef AppModeHandler_t AppModeOps_t[APP_MODE_OP_MAX];
+
 void APP_Setup();
 void APP_Tick();
 void APP_TimeSlice10ms();
@@ -63,6 +103,11 @@ void APP_TimeSlice100ms();
 void APP_TimeSlice500ms();
 void APP_TimeSlice1000ms();
 void APP_InitCurrentApp();
+void APP_Dispatch(AppModeOp_t op);
+void APP_ReloadParams();
+void APP_Fault(FaultCause_t cause);
+uint8_t APP_ModeState();
+void APP_PrintTelemetry();
 void APP_NextMode();
 void APP_OutputToggle();
 void APP_OutputOff();
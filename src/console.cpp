@@ -0,0 +1,344 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#include <Arduino.h>
+
+#include "console.h"
+#include "power.h"
+#include "app.h"
+#include "params.h"
+#include "fault_log.h"
+#include "energy.h"
+#include "modes/list_mode.h"
+#include "modes/cv_mode.h"
+
+// Line buffer
+static char buffer[CONSOLE_BUFFER_SIZE];
+static uint8_t bufferLength = 0;
+// Set while a command is being executed (commands may call SYSTEM_Tick())
+static bool busy = false;
+
+// Local functions
+static void execute(char *line);
+static char *next_token(char **line);
+static bool parse_number(char *token, uint32_t *value);
+static int8_t find_param(char **args);
+static void cmd_params(char *args);
+static void cmd_get(char *args);
+static void cmd_set(char *args);
+static void cmd_save(char *args);
+static void cmd_defaults(char *args);
+static void cmd_faults(char *args);
+static void cmd_status(char *args);
+static void cmd_energy(char *args);
+static void cmd_list(char *args);
+static void cmd_cable(char *args);
+
+// Command names
+static const char cmdParams[] PROGMEM = "params";
+static const char cmdGet[] PROGMEM = "get";
+static const char cmdSet[] PROGMEM = "set";
+static const char cmdSave[] PROGMEM = "save";
+static const char cmdDefaults[] PROGMEM = "defaults";
+static const char cmdFaults[] PROGMEM = "faults";
+static const char cmdStatus[] PROGMEM = "status";
+static const char cmdEnergy[] PROGMEM = "energy";
+static const char cmdList[] PROGMEM = "list";
+static const char cmdCable[] PROGMEM = "cable";
+static const char argClear[] PROGMEM = "clear";
+static const char argAdd[] PROGMEM = "add";
+static const char argRepeat[] PROGMEM = "repeat";
+static const char argSave[] PROGMEM = "save";
+static const char argRun[] PROGMEM = "run";
+static const char argStop[] PROGMEM = "stop";
+
+// Command table
+static const ConsoleCommand_t commands[] PROGMEM = {
+    {cmdParams, cmd_params},     // params - list all tunable params
+    {cmdGet, cmd_get},           // get <name> - print param
+    {cmdSet, cmd_set},           // set <name> <value> - change param
+    {cmdSave, cmd_save},         // save - persist params to EEPROM
+    {cmdDefaults, cmd_defaults}, // defaults - restore default params
+    {cmdFaults, cmd_faults},     // faults [clear] - print or clear fault log
+    {cmdStatus, cmd_status},     // status - print telemetry
+    {cmdEnergy, cmd_energy},     // energy [clear] - print or clear energy counters
+    {cmdList, cmd_list},         // list [add|repeat|clear|save|run|stop] - edit and run output sequence
+    {cmdCable, cmd_cable},       // cable <load mV>|clear - measure output cable resistance from two load points
+};
+
+/// @brief Read serial input and execute complete command lines
+void CONSOLE_TimeSlice10ms()
+{
+  if (busy)
+  {
+    return;
+  }
+
+  while (Serial.available())
+  {
+    char c = Serial.read();
+    POWER_Activity();
+
+    if (c == '\r' || c == '\n')
+    {
+      if (bufferLength > 0)
+      {
+        buffer[bufferLength] = '\0';
+        bufferLength = 0;
+        busy = true;
+        execute(buffer);
+        busy = false;
+      }
+    }
+    else if (bufferLength < CONSOLE_BUFFER_SIZE - 1)
+    {
+      buffer[bufferLength++] = c;
+    }
+  }
+}
+
+// Find and run the command handler
+static void execute(char *line)
+{
+  char *name = next_token(&line);
+
+  for (uint8_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++)
+  {
+    if (strcmp_P(name, (const char *)pgm_read_ptr(&commands[i].name)) == 0)
+    {
+      ((void (*)(char *))pgm_read_ptr(&commands[i].handler))(line);
+      return;
+    }
+  }
+  Serial.println(F("unknown command"));
+}
+
+// Split off the next space separated token, advancing the line pointer
+static char *next_token(char **line)
+{
+  char *token = *line;
+
+  while (**line != '\0' && **line != ' ')
+  {
+    (*line)++;
+  }
+  if (**line == ' ')
+  {
+    **line = '\0';
+    (*line)++;
+  }
+  return token;
+}
+
+// Parse unsigned decimal number token, prints error if it is empty or not a number
+static bool parse_number(char *token, uint32_t *value)
+{
+  char *end;
+
+  *value = strtoul(token, &end, 10);
+  // strtoul also accepts leading whitespace and signs, require plain digits
+  if (*token < '0' || *token > '9' || *end != '\0')
+  {
+    Serial.println(F("invalid number"));
+    return false;
+  }
+  return true;
+}
+
+// Parse param name argument, prints error if not found
+static int8_t find_param(char **args)
+{
+  int8_t index = PARAMS_Find(next_token(args));
+
+  if (index < 0)
+  {
+    Serial.println(F("unknown param"));
+  }
+  return index;
+}
+
+static void cmd_params(char *args)
+{
+  for (uint8_t i = 0; i < PARAMS_Count(); i++)
+  {
+    PARAMS_Print(i);
+  }
+}
+
+static void cmd_get(char *args)
+{
+  int8_t index = find_param(&args);
+
+  if (index >= 0)
+  {
+    PARAMS_Print(index);
+  }
+}
+
+static void cmd_set(char *args)
+{
+  int8_t index = find_param(&args);
+
+  if (index < 0)
+  {
+    return;
+  }
+  uint32_t value;
+  if (!parse_number(args, &value))
+  {
+    return;
+  }
+  if (!PARAMS_Set(index, value))
+  {
+    Serial.println(F("out of range"));
+    return;
+  }
+  APP_ReloadParams();
+  PARAMS_Print(index);
+}
+
+static void cmd_save(char *args)
+{
+  PARAMS_Save();
+  Serial.println(F("ok"));
+}
+
+static void cmd_defaults(char *args)
+{
+  PARAMS_Reset();
+  APP_ReloadParams();
+  Serial.println(F("ok"));
+}
+
+static void cmd_faults(char *args)
+{
+  if (strcmp_P(next_token(&args), argClear) == 0)
+  {
+    FAULT_LOG_Clear();
+  }
+  FAULT_LOG_Print();
+}
+
+static void cmd_status(char *args)
+{
+  APP_PrintTelemetry();
+}
+
+static void cmd_energy(char *args)
+{
+  if (strcmp_P(next_token(&args), argClear) == 0)
+  {
+    ENERGY_Clear();
+  }
+  ENERGY_Print();
+}
+
+static void cmd_list(char *args)
+{
+  char *arg = next_token(&args);
+
+  if (strcmp_P(arg, argAdd) == 0)
+  {
+    ListStepType_t type = LIST_MODE_FindType(next_token(&args));
+    uint32_t setpoint, limit, duration_ms;
+    if (!parse_number(next_token(&args), &setpoint) || !parse_number(next_token(&args), &limit) ||
+        !parse_number(next_token(&args), &duration_ms))
+    {
+      return;
+    }
+    if (!LIST_MODE_Add(type, setpoint, limit, duration_ms / 10))
+    {
+      Serial.println(F("invalid step"));
+      return;
+    }
+  }
+  else if (strcmp_P(arg, argRepeat) == 0)
+  {
+    uint32_t repeat;
+    if (!parse_number(args, &repeat))
+    {
+      return;
+    }
+    if (repeat > UINT8_MAX)
+    {
+      Serial.println(F("out of range"));
+      return;
+    }
+    LIST_MODE_SetRepeat(repeat);
+  }
+  else if (strcmp_P(arg, argClear) == 0)
+  {
+    LIST_MODE_Clear();
+  }
+  else if (strcmp_P(arg, argSave) == 0)
+  {
+    LIST_MODE_Save();
+  }
+  else if ((strcmp_P(arg, argRun) == 0 || strcmp_P(arg, argStop) == 0) &&
+           (gSettings.mode == APP_MODE_ERROR || gSettings.mode == APP_MODE_CALIBRATION))
+  {
+    // error mode decides on recovery itself (latched faults need a reboot), calibration owns the output
+    Serial.println(F("not available in this mode"));
+    return;
+  }
+  else if (strcmp_P(arg, argRun) == 0)
+  {
+    gSettings.mode = APP_MODE_LIST;
+    APP_OutputOn();
+    APP_InitCurrentApp();
+  }
+  else if (strcmp_P(arg, argStop) == 0)
+  {
+    APP_OutputOff();
+    APP_InitCurrentApp();
+  }
+  LIST_MODE_Print();
+}
+
+static void cmd_cable(char *args)
+{
+  char *arg = next_token(&args);
+
+  if (strcmp_P(arg, argClear) == 0)
+  {
+    CV_MODE_ClearCable();
+    Serial.println(F("ok"));
+    return;
+  }
+
+  uint32_t load_voltage;
+  if (!parse_number(arg, &load_voltage))
+  {
+    return;
+  }
+
+  int32_t resistance = CV_MODE_MeasureCable(load_voltage);
+  if (resistance < 0)
+  {
+    Serial.println(F("change load and enter next point"));
+    return;
+  }
+
+  int8_t index = PARAMS_Find("cv_cable");
+  if (!PARAMS_Set(index, resistance))
+  {
+    Serial.print(resistance);
+    Serial.println(F(" out of range"));
+    return;
+  }
+  APP_ReloadParams();
+  PARAMS_Print(index);
+}
@@ -0,0 +1,32 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+// Serial console line buffer size (longest accepted command line)
+#define CONSOLE_BUFFER_SIZE 32
+
+// Serial console command
+typedef struct
+{
+    const char *name;            // command name (stored in flash)
+    void (*handler)(char *args); // command handler, args points to the rest of the line
+} ConsoleCommand_t;
+
+void CONSOLE_TimeSlice10ms();
+
+#endif
@@ -179,6 +179,33 @@ uint16_t ADC_OutputVoltageVal()
   return adcValue;
 }
 
+/// @brief
+/// @return Returns temperature in 0.1°C
+int16_t ADC_TemperatureVal()
+{
+  uint64_t adcValue = ADC_analogRead(TEMPERATURE_PIN, TEMPERATURE_OVERSAMPLE_BITS); // Raw value
+  adcValue = (adcValue * ADC_REF_VOLTAGE_VALUE) / TEMPERATURE_ACTUAL_ADC_MAX_VAL;    // Sensor output in mV
+  return adcValue / TEMPERATURE_MV_PER_DECI_DEGREE;
+}
+
+/// @brief Enable or disable syncing ADC reads with TIMER0 overflow (disable when TIMER0 is stopped)
+/// @param enabled true to enable auto trigger
+void ADC_SetAutoTrigger(bool enabled)
+{
+#ifdef ADC_AUTO_TRIGGER
+  noInterrupts();
+  if (enabled)
+  {
+    ADCSRA |= (1 << ADATE);
+  }
+  else
+  {
+    ADCSRA &= ~(1 << ADATE);
+  }
+  interrupts();
+#endif
+}
+
 #ifdef ADC_AUTO_TRIGGER
 // This sync ADC reads with PWM output on TIMER0 preventing noise and glitches
 static void adc_setup_auto_trigger()
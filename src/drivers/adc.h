@@ -115,13 +115,30 @@
 // TODO: Might need to lower it to 14 for other modes to prevent oscilation
 // #define OUTPUT_VOLTAGE_FILTER_ATT 77
 
+// Temperature sensor - if defined an analog temperature sensor (LM35 or compatible, 10mV/°C) placed
+// next to the MOSFET and diode is read on the spare TEMPERATURE_PIN, leave undefined if sensor is not fitted
+// note: LGT8F328P has no usable internal temperature sensor channel
+// #define TEMPERATURE_SENSOR
+// Temperature sensor pin
+#define TEMPERATURE_PIN A6
+// Oversample bits - by oversampling and decimation it adds extra bits of resolution to the ADC readings
+#define TEMPERATURE_OVERSAMPLE_BITS 2
+// Actual resolution is the sum of hardware ADC resolution and oversample bits
+#define TEMPERATURE_ACTUAL_ADC_RESOLUTION SUM(ADC_HARDWARE_RESOLUTION, TEMPERATURE_OVERSAMPLE_BITS)
+// Max actual value of the ADC
+#define TEMPERATURE_ACTUAL_ADC_MAX_VAL POW(2, TEMPERATURE_ACTUAL_ADC_RESOLUTION)
+// Sensor output in 0.1mV per 0.1°C (10mV/°C sensor gives 1mV per 0.1°C)
+#define TEMPERATURE_MV_PER_DECI_DEGREE 1
+
 void ADC_Setup();
+void ADC_SetAutoTrigger(bool enabled);
 uint16_t ADC_analogDiffRead(uint8_t negativePin, uint8_t positivePin, uint8_t gain, uint8_t oversampleBits);
 uint16_t ADC_analogRead(uint8_t pin, uint8_t oversampleBits);
 uint16_t ADC_InputCurrentVal();
 uint16_t ADC_OutputCurrentVal();
 uint16_t ADC_InputVoltageVal();
 uint16_t ADC_OutputVoltageVal();
+int16_t ADC_TemperatureVal();
 void BOARD_Reset();
 
 #endif
\ No newline at end of file
@@ -19,32 +19,21 @@
 #include "button.h"
 #include "app.h"
 #include "settings.h"
-#include "modes/idle_mode.h"
-#include "modes/cv_mode.h"
-#include "modes/cc_mode.h"
-#include "modes/mppt_mode.h"
-#include "modes/error_mode.h"
-#include "modes/charge_mode.h"
-#include "modes/calibration_mode.h"
+#include "power.h"
 
-// Button interrupt flags
-volatile bool modeButtonPressed, outputButtonPressed = 0;
+// Button state machines, indexed by ButtonId_t
+static Button_t buttons[BUTTON_MAX] = {
+    {BUTTON_PIN_MODE, 0, false, false, false, false, 0, UINT8_MAX},
+    {BUTTON_PIN_OUTPUT, 0, false, false, false, false, 0, UINT8_MAX},
+};
 
-// Counter for keeping track how long the button was pressed
-uint8_t modeButtonPressed100ms, outputButtonPressed100ms = 0;
-
-// Scheduler counter for attaching interrupt
-uint8_t modeButtonScheduleIntAttach100ms, outputButtonScheduleIntAttach100ms = 0;
-
-bool modeButtonWasLongPressed, outputButtonWasLongPressed = false;
+// Output button held event being handled is an auto-repeat
+static bool repeating = false;
 
 // Local functions
-static void mode_btn_falling_intr();
-static void output_btn_falling_intr();
-static void mode_btn_interrupt_scheduler_100ms();
-static void output_btn_interrupt_scheduler_100ms();
-static void mode_btn_handler_100ms();
-static void output_btn_handler_100ms();
+static void update_button(ButtonId_t id);
+static void detect_chord();
+static void handle_event(ButtonId_t id, ButtonEvent_t event);
 
 /// @brief Setup buttons
 void BUTTON_Setup()
@@ -52,21 +41,18 @@ void BUTTON_Setup()
   // Enable internal pull-up
   pinMode(BUTTON_PIN_MODE, INPUT_PULLUP);
   pinMode(BUTTON_PIN_OUTPUT, INPUT_PULLUP);
-  // Attach interrupt
-  attachInterrupt(digitalPinToInterrupt(BUTTON_PIN_MODE), mode_btn_falling_intr, FALLING);
-  attachInterrupt(digitalPinToInterrupt(BUTTON_PIN_OUTPUT), output_btn_falling_intr, FALLING);
+  // buttons held during boot select calibration mode, they are not presses
+  BUTTON_IgnoreHeld();
 }
 
 void BUTTON_TimeSlice10ms()
 {
+  update_button(BUTTON_MODE);
+  update_button(BUTTON_OUTPUT);
+  detect_chord();
 }
 void BUTTON_TimeSlice100ms()
 {
-  mode_btn_interrupt_scheduler_100ms();
-  mode_btn_handler_100ms();
-
-  output_btn_interrupt_scheduler_100ms();
-  output_btn_handler_100ms();
 }
 void BUTTON_TimeSlice500ms()
 {
@@ -75,261 +61,170 @@ void BUTTON_TimeSlice1000ms()
 {
 }
 
+/// @brief Ignore presses in progress until buttons are released (i.e. the press that woke the device up)
+void BUTTON_IgnoreHeld()
+{
+  for (uint8_t i = 0; i < BUTTON_MAX; i++)
+  {
+    if (!digitalRead(buttons[i].pin))
+    {
+      buttons[i].history = UINT8_MAX;
+      buttons[i].pressed = true;
+      buttons[i].suppressed = true;
+    }
+  }
+}
+
 // Handle application level logic when mode button was pressed
 void BUTTON_ModePressed()
 {
   // send event to appropriate handler
-  switch (gSettings.mode)
-  {
-  case APP_MODE_IDLE:
-    IDLE_MODE_ModeBtnPressed();
-    break;
-  case APP_MODE_CV:
-    CV_MODE_ModeBtnPressed();
-    break;
-  case APP_MODE_CC:
-    CC_MODE_ModeBtnPressed();
-    break;
-  case APP_MODE_CHARGE:
-    CHARGE_MODE_ModeBtnPressed();
-    break;
-  case APP_MODE_MPPT:
-    MPPT_MODE_ModeBtnPressed();
-    break;
-  case APP_MODE_ERROR:
-    ERROR_MODE_ModeBtnPressed();
-    break;
-  case APP_MODE_CALIBRATION:
-    CALIBRATION_MODE_ModeBtnPressed();
-    break;
-  default:
-    break;
-  }
+  APP_Dispatch(APP_MODE_OP_MODE_BTN_PRESSED);
 }
 
 // Handle application level logic when mode button was held
 void BUTTON_ModeHeld()
 {
   // send event to appropriate handler
-  switch (gSettings.mode)
-  {
-  case APP_MODE_IDLE:
-    IDLE_MODE_ModeBtnHeld();
-    break;
-  case APP_MODE_CV:
-    CV_MODE_ModeBtnHeld();
-    break;
-  case APP_MODE_CC:
-    CC_MODE_ModeBtnHeld();
-    break;
-  case APP_MODE_CHARGE:
-    CHARGE_MODE_ModeBtnHeld();
-    break;
-  case APP_MODE_MPPT:
-    MPPT_MODE_ModeBtnHeld();
-    break;
-  case APP_MODE_ERROR:
-    ERROR_MODE_ModeBtnHeld();
-    break;
-  case APP_MODE_CALIBRATION:
-    CALIBRATION_MODE_ModeBtnHeld();
-    break;
-  default:
-    break;
-  }
+  APP_Dispatch(APP_MODE_OP_MODE_BTN_HELD);
 }
 
 // Handle application level logic when output button was pressed
 void BUTTON_OutputPressed()
 {
   // send event to appropriate handler
-  switch (gSettings.mode)
-  {
-  case APP_MODE_IDLE:
-    IDLE_MODE_OutputBtnPressed();
-    break;
-  case APP_MODE_CV:
-    CV_MODE_OutputBtnPressed();
-    break;
-  case APP_MODE_CC:
-    CC_MODE_OutputBtnPressed();
-    break;
-  case APP_MODE_CHARGE:
-    CHARGE_MODE_OutputBtnPressed();
-    break;
-  case APP_MODE_MPPT:
-    MPPT_MODE_OutputBtnPressed();
-    break;
-  case APP_MODE_ERROR:
-    ERROR_MODE_OutputBtnPressed();
-    break;
-  case APP_MODE_CALIBRATION:
-    CALIBRATION_MODE_OutputBtnPressed();
-    break;
-  default:
-    break;
-  }
+  APP_Dispatch(APP_MODE_OP_OUTPUT_BTN_PRESSED);
 }
 
 // Handle application level logic when output button was held
 void BUTTON_OutputHeld()
 {
   // send event to appropriate handler
-  switch (gSettings.mode)
-  {
-  case APP_MODE_IDLE:
-    IDLE_MODE_OutputBtnHeld();
-    break;
-  case APP_MODE_CV:
-    CV_MODE_OutputBtnHeld();
-    break;
-  case APP_MODE_CC:
-    CC_MODE_OutputBtnHeld();
-    break;
-  case APP_MODE_CHARGE:
-    CHARGE_MODE_OutputBtnHeld();
-    break;
-  case APP_MODE_MPPT:
-    MPPT_MODE_OutputBtnHeld();
-    break;
-  case APP_MODE_ERROR:
-    ERROR_MODE_OutputBtnHeld();
-    break;
-  case APP_MODE_CALIBRATION:
-    CALIBRATION_MODE_OutputBtnHeld();
-    break;
-  default:
-    break;
-  }
+  APP_Dispatch(APP_MODE_OP_OUTPUT_BTN_HELD);
 }
 
-// Local interrupt function called on falling edge detection across mode button
-static void mode_btn_falling_intr()
-{
-  modeButtonPressed = 1;
-  detachInterrupt(digitalPinToInterrupt(BUTTON_PIN_MODE));
-}
-// Local interrupt function called on falling edge detection across output button
-static void output_btn_falling_intr()
+/// @brief Check if output button held event being handled is an auto-repeat,
+/// handlers saturate instead of wrapping around (or ignore it) so holding the button can't run away
+/// @return true while handling auto-repeat
+bool BUTTON_Repeating()
 {
-  outputButtonPressed = 1;
-  detachInterrupt(digitalPinToInterrupt(BUTTON_PIN_OUTPUT));
+  return repeating;
 }
 
-// Local mode button interrupt scheduler
-static void mode_btn_interrupt_scheduler_100ms()
+// Sample button, debounce it and emit events
+static void update_button(ButtonId_t id)
 {
-  // check if there is interrupt re-attachment scheduled
-  if (modeButtonScheduleIntAttach100ms > 0)
+  Button_t *button = &buttons[id];
+
+  // buttons are active low
+  button->history = (button->history << 1) | !digitalRead(button->pin);
+
+  if (button->since_click_10ms < UINT8_MAX)
   {
-    // if so decrement the scheduler counter
-    modeButtonScheduleIntAttach100ms--;
-    // on last decrement attach the interrupt
-    if (modeButtonScheduleIntAttach100ms == 0)
-    {
-      attachInterrupt(digitalPinToInterrupt(BUTTON_PIN_MODE), mode_btn_falling_intr, FALLING);
-    }
+    button->since_click_10ms++;
   }
-}
 
-// Local output button interrupt scheduler
-static void output_btn_interrupt_scheduler_100ms()
-{
-  // check if there is interrupt re-attachment scheduled
-  if (outputButtonScheduleIntAttach100ms > 0)
+  // debounced press
+  if (!button->pressed && (button->history & BUTTON_DEBOUNCE_MASK) == BUTTON_DEBOUNCE_MASK)
   {
-    // if so decrement the scheduler counter
-    outputButtonScheduleIntAttach100ms--;
-    // on last decrement attach the interrupt
-    if (outputButtonScheduleIntAttach100ms == 0)
-    {
-      attachInterrupt(digitalPinToInterrupt(BUTTON_PIN_OUTPUT), output_btn_falling_intr, FALLING);
-    }
+    button->pressed = true;
+    button->long_pressed = false;
+    button->held_10ms = 0;
+    button->double_click = (button->since_click_10ms <= BUTTON_DOUBLE_CLICK_10MS);
+    handle_event(id, BUTTON_EVENT_PRESS);
   }
-}
-
-// Local mode button handler
-static void mode_btn_handler_100ms()
-{
-  // mode button falling edge detected
-  if (modeButtonPressed)
+  // debounced release
+  else if (button->pressed && (button->history & BUTTON_DEBOUNCE_MASK) == 0)
   {
-    // if button is pressed
-    if (!digitalRead(BUTTON_PIN_MODE))
-    {
-      // button is still being held so count how many 100ms timeslices is being held for
-      modeButtonPressed100ms += 1;
+    button->pressed = false;
+    handle_event(id, BUTTON_EVENT_RELEASE);
 
-      // decide based on modeButtonPressed100ms counter how long the button was held for
-      if (modeButtonPressed100ms > (BUTTON_TIMEOUT_SEC * _100MS_TO_SEC))
-      {
-        // long press detected
-        BUTTON_ModeHeld();
-        modeButtonPressed100ms = 0;
-        modeButtonWasLongPressed = true;
-      }
-    }
-    else
-    // button was released so process action
+    if (!button->suppressed && !button->long_pressed)
     {
-      // reset
-      modeButtonPressed = 0;
-      modeButtonPressed100ms = 0;
-      // if it was long pressed - reset the flag
-      if (modeButtonWasLongPressed)
+      handle_event(id, BUTTON_EVENT_CLICK);
+      if (button->double_click)
       {
-        modeButtonWasLongPressed = false;
+        handle_event(id, BUTTON_EVENT_DOUBLE_CLICK);
+        // third click starts a new double-click
+        button->since_click_10ms = UINT8_MAX;
       }
-      // otherwise it was not held long enough so process it as a short press
       else
       {
-        BUTTON_ModePressed();
+        button->since_click_10ms = 0;
       }
-      // schedule interrupt re-attachment in 2x100ms = 200ms
-      modeButtonScheduleIntAttach100ms = 2;
+    }
+    button->suppressed = false;
+  }
+  // held
+  else if (button->pressed && !button->suppressed)
+  {
+    button->held_10ms++;
+    if (!button->long_pressed && button->held_10ms >= BUTTON_LONG_PRESS_10MS)
+    {
+      button->long_pressed = true;
+      button->held_10ms = 0;
+      handle_event(id, BUTTON_EVENT_LONG_PRESS);
+    }
+    else if (button->long_pressed && button->held_10ms >= BUTTON_REPEAT_10MS)
+    {
+      button->held_10ms = 0;
+      handle_event(id, BUTTON_EVENT_REPEAT);
     }
   }
 }
 
-// Local output button handler
-static void output_btn_handler_100ms()
+// Detect both buttons pressed together
+static void detect_chord()
 {
-  // output button falling edge detected
-  if (outputButtonPressed)
+  if (buttons[BUTTON_MODE].pressed && buttons[BUTTON_OUTPUT].pressed &&
+      !buttons[BUTTON_MODE].suppressed && !buttons[BUTTON_OUTPUT].suppressed)
   {
-    // if button is pressed
-    if (!digitalRead(BUTTON_PIN_OUTPUT))
-    {
-      // button is still being held so count how many 100ms timeslices is being held for
-      outputButtonPressed100ms += 1;
+    // neither button emits click or long press until released
+    buttons[BUTTON_MODE].suppressed = true;
+    buttons[BUTTON_OUTPUT].suppressed = true;
+    handle_event(BUTTON_MODE, BUTTON_EVENT_CHORD);
+  }
+}
 
-      // decide based on outputButtonPressed100ms counter how long the button was held for
-      if (outputButtonPressed100ms > (BUTTON_TIMEOUT_SEC * _100MS_TO_SEC))
-      {
-        // long press detected
-        BUTTON_OutputHeld();
-        outputButtonPressed100ms = 0;
-        outputButtonWasLongPressed = true;
-      }
+// Map button events to application actions
+static void handle_event(ButtonId_t id, ButtonEvent_t event)
+{
+#ifdef EXTRA_DEBUG_MODE
+  Serial.print(F("button: "));
+  Serial.print(id);
+  Serial.print(F(" event: "));
+  Serial.println(event);
+#endif
+
+  switch (event)
+  {
+  case BUTTON_EVENT_PRESS:
+    POWER_Activity();
+    break;
+  case BUTTON_EVENT_CLICK:
+    (id == BUTTON_MODE) ? BUTTON_ModePressed() : BUTTON_OutputPressed();
+    break;
+  case BUTTON_EVENT_LONG_PRESS:
+    (id == BUTTON_MODE) ? BUTTON_ModeHeld() : BUTTON_OutputHeld();
+    break;
+  case BUTTON_EVENT_REPEAT:
+    // keep scrolling output params while output button is held
+    if (id == BUTTON_OUTPUT)
+    {
+      repeating = true;
+      BUTTON_OutputHeld();
+      repeating = false;
     }
-    else
-    // button was released so process action
+    break;
+  case BUTTON_EVENT_CHORD:
+    // both buttons - turn output off immediately
+    if (gSettings.output && gSettings.mode != APP_MODE_CALIBRATION)
     {
-      // reset
-      outputButtonPressed = 0;
-      outputButtonPressed100ms = 0;
-      // if it was long pressed - reset the flag
-      if (outputButtonWasLongPressed)
-      {
-        outputButtonWasLongPressed = false;
-      }
-      // otherwise it was not held long enough so process it as a short press
-      else
-      {
-        BUTTON_OutputPressed();
-      }
-      // schedule interrupt re-attachment in 2x100ms = 200ms
-      outputButtonScheduleIntAttach100ms = 2;
+      APP_OutputToggle();
     }
+    break;
+  default:
+    // release and double-click are not bound to any action yet
+    break;
   }
-}
\ No newline at end of file
+}
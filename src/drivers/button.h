@@ -17,6 +17,8 @@
 #ifndef BUTTON_H
 #define BUTTON_H
 
+#include <stdint.h>
+
 // Mode button pin number
 #define BUTTON_PIN_MODE 2
 // Output button pin number
@@ -25,17 +27,63 @@
 // Button hold timeout in seconds (determines long press / hold button event)
 #define BUTTON_TIMEOUT_SEC 2
 
-// Helper to determine how many 100ms slices are in 1 second
-#define _100MS_TO_SEC 10
+// Helper to determine how many 10ms slices are in 1 second
+#define _10MS_TO_SEC 100
+
+// Debounce mask - button state changes once that many consecutive 10ms samples agree
+#define BUTTON_DEBOUNCE_MASK 0x07 // 3 samples = 30ms
+// Long press time in 10ms
+#define BUTTON_LONG_PRESS_10MS (BUTTON_TIMEOUT_SEC * _10MS_TO_SEC)
+// Auto-repeat period in 10ms while button is held after long press
+#define BUTTON_REPEAT_10MS 25 // 25*10ms = 250ms
+// Max time in 10ms between release and next press to detect double-click
+#define BUTTON_DOUBLE_CLICK_10MS 30 // 30*10ms = 300ms
+
+// Buttons
+enum ButtonId_t : uint8_t
+{
+    BUTTON_MODE = 0, // mode button
+    BUTTON_OUTPUT,   // output button
+    BUTTON_MAX       // not used, buttons count
+};
+typedef enum ButtonId_t ButtonId_t;
+
+// Button events
+enum ButtonEvent_t : uint8_t
+{
+    BUTTON_EVENT_PRESS = 0,     // debounced press
+    BUTTON_EVENT_RELEASE,       // debounced release
+    BUTTON_EVENT_CLICK,         // released before long press
+    BUTTON_EVENT_DOUBLE_CLICK,  // second click within BUTTON_DOUBLE_CLICK_10MS (follows the click event)
+    BUTTON_EVENT_LONG_PRESS,    // held for BUTTON_LONG_PRESS_10MS
+    BUTTON_EVENT_REPEAT,        // every BUTTON_REPEAT_10MS while held after long press
+    BUTTON_EVENT_CHORD          // both buttons pressed together (reported for BUTTON_MODE)
+};
+typedef enum ButtonEvent_t ButtonEvent_t;
+
+// Button state machine
+typedef struct
+{
+    uint8_t pin;               // button pin
+    uint8_t history;           // last raw samples, 1 - pressed
+    bool pressed;              // debounced state
+    bool long_pressed;         // long press event was emitted during this press
+    bool suppressed;           // press is part of a chord - no click/long press events until release
+    bool double_click;         // press started within double-click window
+    uint16_t held_10ms;        // how long the button is pressed for in 10ms
+    uint8_t since_click_10ms;  // time in 10ms since last click (saturates)
+} Button_t;
 
 void BUTTON_Setup();
+void BUTTON_IgnoreHeld();
 void BUTTON_ModePressed();
 void BUTTON_ModeHeld();
 void BUTTON_OutputPressed();
 void BUTTON_OutputHeld();
+bool BUTTON_Repeating();
 void BUTTON_TimeSlice10ms();
 void BUTTON_TimeSlice100ms();
 void BUTTON_TimeSlice500ms();
 void BUTTON_TimeSlice1000ms();
 
-#endif
\ No newline at end of file
+#endif
@@ -22,43 +22,115 @@
 // Global LED struct
 Led_t gLed;
 
+// LED pins in LED index order (stored in flash)
+static const uint8_t ledPinNumbers[LED_COUNT] PROGMEM = {
+    LED_CV_MODE_PIN,
+    LED_CC_MODE_PIN,
+    LED_CHARGE_MODE_PIN,
+    LED_ERROR_MODE_PIN,
+    LED_OUTPUT_X1_PIN,
+    LED_OUTPUT_X2_PIN,
+    LED_OUTPUT_X3_PIN,
+    LED_OUTPUT_X4_PIN,
+    LED_OUTPUT_X5_PIN,
+    LED_OUTPUT_X6_PIN,
+    LED_OUTPUT_X7_PIN,
+    LED_OUTPUT_X8_PIN};
+
+// LED states in LED index order
+static bool *const ledStates[LED_COUNT] = {
+    &gLed.cv,
+    &gLed.cc,
+    &gLed.charge,
+    &gLed.error,
+    &gLed.x1,
+    &gLed.x2,
+    &gLed.x3,
+    &gLed.x4,
+    &gLed.x5,
+    &gLed.x6,
+    &gLed.x7,
+    &gLed.x8};
+
+// Index of the X1 LED, first LED of the bar graph
+#define LED_BAR_FIRST 4
+
+// Precomputed port masks
+static LedPort_t ports[LED_PORTS_MAX];
+static uint8_t portsCount;
+static LedPin_t pins[LED_COUNT];
+// Fractional bar graph LED, accessed from TIMER2 interrupts
+static volatile LedPwm_t barPwm;
+
+// Local functions
+static void pwm_disable();
+
+// Interrupt handler when TIMER2 reaches OCR2B - end of the fractional LED on time
+ISR(TIMER2_COMPB_vect)
+{
+  if (barPwm.port)
+  {
+    *barPwm.port &= ~barPwm.mask;
+  }
+}
+
 /// @brief Led setup
 void LED_Setup()
 {
   // init led type
   LED_Clear();
-  // setup pins
-  pinMode(LED_CV_MODE_PIN, OUTPUT);
-  pinMode(LED_CC_MODE_PIN, OUTPUT);
-  pinMode(LED_CHARGE_MODE_PIN, OUTPUT);
-  pinMode(LED_ERROR_MODE_PIN, OUTPUT);
-  pinMode(LED_OUTPUT_X1_PIN, OUTPUT);
-  pinMode(LED_OUTPUT_X2_PIN, OUTPUT);
-  pinMode(LED_OUTPUT_X3_PIN, OUTPUT);
-  pinMode(LED_OUTPUT_X4_PIN, OUTPUT);
-  pinMode(LED_OUTPUT_X5_PIN, OUTPUT);
-  pinMode(LED_OUTPUT_X6_PIN, OUTPUT);
-  pinMode(LED_OUTPUT_X7_PIN, OUTPUT);
-  pinMode(LED_OUTPUT_X8_PIN, OUTPUT);
+  // setup pins and group them by port
+  for (uint8_t i = 0; i < LED_COUNT; i++)
+  {
+    uint8_t pin = pgm_read_byte(&ledPinNumbers[i]);
+    volatile uint8_t *port = portOutputRegister(digitalPinToPort(pin));
+    uint8_t p = 0;
+
+    pinMode(pin, OUTPUT);
+
+    while (p < portsCount && ports[p].port != port)
+    {
+      p++;
+    }
+    if (p == portsCount)
+    {
+      ports[portsCount].port = port;
+      ports[portsCount].mask = 0;
+      portsCount++;
+    }
+    pins[i].port = p;
+    pins[i].mask = digitalPinToBitMask(pin);
+    ports[p].mask |= pins[i].mask;
+  }
 }
 void LED_TimeSlice10ms()
 {
   // if LED pins need an update
   if (gLed.needs_update)
   {
-    // update all the pins
-    digitalWrite(LED_CV_MODE_PIN, gLed.cv);
-    digitalWrite(LED_CC_MODE_PIN, gLed.cc);
-    digitalWrite(LED_CHARGE_MODE_PIN, gLed.charge);
-    digitalWrite(LED_ERROR_MODE_PIN, gLed.error);
-    digitalWrite(LED_OUTPUT_X1_PIN, gLed.x1);
-    digitalWrite(LED_OUTPUT_X2_PIN, gLed.x2);
-    digitalWrite(LED_OUTPUT_X3_PIN, gLed.x3);
-    digitalWrite(LED_OUTPUT_X4_PIN, gLed.x4);
-    digitalWrite(LED_OUTPUT_X5_PIN, gLed.x5);
-    digitalWrite(LED_OUTPUT_X6_PIN, gLed.x6);
-    digitalWrite(LED_OUTPUT_X7_PIN, gLed.x7);
-    digitalWrite(LED_OUTPUT_X8_PIN, gLed.x8);
+    uint8_t values[LED_PORTS_MAX] = {0};
+
+    for (uint8_t i = 0; i < LED_COUNT; i++)
+    {
+      if (*ledStates[i])
+      {
+        values[pins[i].port] |= pins[i].mask;
+      }
+    }
+
+    // update all the pins - one masked write per port
+    noInterrupts();
+    for (uint8_t p = 0; p < portsCount; p++)
+    {
+      uint8_t mask = ports[p].mask;
+      // fractional LED is driven by the software PWM
+      if (barPwm.port == ports[p].port)
+      {
+        mask &= ~barPwm.mask;
+      }
+      *ports[p].port = (*ports[p].port & ~mask) | values[p];
+    }
+    interrupts();
     // reset the flag
     gLed.needs_update = 0;
   }
@@ -76,23 +148,86 @@ void LED_TimeSlice1000ms()
 /// @brief Clear LED struct
 void LED_Clear()
 {
+  pwm_disable();
   gLed.needs_update = 0;
-  gLed.cv = 0;
-  gLed.cc = 0;
-  gLed.charge = 0;
-  gLed.error = 0;
-  gLed.x1 = 0;
-  gLed.x2 = 0;
-  gLed.x3 = 0;
-  gLed.x4 = 0;
-  gLed.x5 = 0;
-  gLed.x6 = 0;
-  gLed.x7 = 0;
-  gLed.x8 = 0;
+  for (uint8_t i = 0; i < LED_COUNT; i++)
+  {
+    *ledStates[i] = 0;
+  }
   // tell to refresh
   gLed.needs_update = 1;
 }
 
+/// @brief Render bar graph on X1..X7 LEDs, the last partially lit LED is dimmed via software PWM
+/// @param level bar level (0-LED_BAR_MAX), LED_BAR_LED_LEVEL per LED
+void LED_SetBar(uint16_t level)
+{
+  if (level > LED_BAR_MAX)
+  {
+    level = LED_BAR_MAX;
+  }
+
+  uint8_t full = level / LED_BAR_LED_LEVEL;
+  uint8_t fraction = level % LED_BAR_LED_LEVEL;
+
+  for (uint8_t i = 0; i < LED_BAR_LEDS; i++)
+  {
+    *ledStates[LED_BAR_FIRST + i] = (i < full);
+  }
+
+  if (fraction == 0)
+  {
+    pwm_disable();
+  }
+  else
+  {
+    uint8_t led = LED_BAR_FIRST + full;
+
+    noInterrupts();
+    barPwm.port = ports[pins[led].port].port;
+    barPwm.mask = pins[led].mask;
+    // TIMER2 counts up and down in phase correct mode, LED is lit from BOTTOM to OCR2B when counting up
+    // so full fraction gives 50% of the period
+    OCR2B = ((uint16_t)fraction * OCR2A) / LED_BAR_LED_LEVEL;
+    TIMSK2 |= 1 << OCIE2B;
+    interrupts();
+  }
+  gLed.needs_update = 1;
+}
+
+/// @brief Clear bar graph
+void LED_ClearBar()
+{
+  pwm_disable();
+  for (uint8_t i = 0; i < LED_BAR_LEDS; i++)
+  {
+    *ledStates[LED_BAR_FIRST + i] = 0;
+  }
+  gLed.needs_update = 1;
+}
+
+/// @brief Start of the fractional LED on time, called from TIMER2 overflow interrupt
+void LED_PwmOverflow()
+{
+  if (barPwm.port)
+  {
+    *barPwm.port |= barPwm.mask;
+  }
+}
+
+// Stop software PWM and turn off the fractional LED
+static void pwm_disable()
+{
+  noInterrupts();
+  TIMSK2 &= ~(1 << OCIE2B);
+  if (barPwm.port)
+  {
+    *barPwm.port &= ~barPwm.mask;
+  }
+  barPwm.port = NULL;
+  interrupts();
+}
+
 // /// @brief Set IN PROTECT LED state hack that uses internal pull-up to drive the LED
 // /// DO NOT USE - it causes unstable MCU behavior
 // /// @param state desired state
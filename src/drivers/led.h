@@ -17,6 +17,8 @@
 #ifndef LED_H
 #define LED_H
 
+#include <stdint.h>
+
 // LED pin
 #define LED_CV_MODE_PIN E3
 #define LED_CC_MODE_PIN E6
@@ -31,6 +33,38 @@
 #define LED_OUTPUT_X7_PIN D12
 #define LED_OUTPUT_X8_PIN D4
 
+// Number of LEDs
+#define LED_COUNT 12
+// Max amount of ports LEDs are connected to
+#define LED_PORTS_MAX 4
+// Number of LEDs in the bar graph (X1..X7, X8 stays the output status LED)
+#define LED_BAR_LEDS 7
+// Bar graph level of one fully lit LED
+#define LED_BAR_LED_LEVEL 256
+// Bar graph full scale level
+#define LED_BAR_MAX (LED_BAR_LEDS * LED_BAR_LED_LEVEL)
+
+// LEDs connected to a single port
+typedef struct
+{
+    volatile uint8_t *port; // port output register
+    uint8_t mask;           // pins of all LEDs on this port
+} LedPort_t;
+
+// LED pin
+typedef struct
+{
+    uint8_t port; // index of the port in the ports table
+    uint8_t mask; // pin bit mask
+} LedPin_t;
+
+// Software PWM driven LED (fractional LED of the bar graph)
+typedef struct
+{
+    volatile uint8_t *port; // port output register, NULL when software PWM is off
+    uint8_t mask;           // pin bit mask
+} LedPwm_t;
+
 typedef struct
 {
     bool needs_update; // flag indicating request to change LED values
@@ -57,5 +91,8 @@ void LED_TimeSlice100ms();
 void LED_TimeSlice500ms();
 void LED_TimeSlice1000ms();
 void LED_Clear();
+void LED_SetBar(uint16_t level);
+void LED_ClearBar();
+void LED_PwmOverflow();
 
 #endif
\ No newline at end of file
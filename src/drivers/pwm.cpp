@@ -18,11 +18,28 @@
 
 #include "pwm.h"
 #include "app.h"
+#include "params.h"
+#include "settings.h"
 
 // Local functions
 static void auto_adjust_mode();
+static void optimise_100ms();
+static void optimiser_start();
+static void optimiser_apply(PWM_MODE_t mode);
+static void optimiser_evaluate();
+static bool operating_point_changed();
 
 static Pwm_t pwm;
+static PwmOptimiser_t optimiser;
+static PwmBurst_t burst;
+
+// Switching frequencies evaluated by the efficiency optimiser
+static const PWM_MODE_t optimiserCandidates[] PROGMEM = {
+    PWM_MODE_FAST_PWM_15KHZ,
+    PWM_MODE_FAST_PWM_31KHZ,
+    PWM_MODE_PC_PWM_63KHZ,
+    PWM_MODE_FAST_PWM_125KHZ};
+#define PWM_OPTIMISER_CANDIDATES (sizeof(optimiserCandidates) / sizeof(optimiserCandidates[0]))
 
 /// @brief Setup PWM on Timer 0, pin D6
 //  the higher the freq, the higher the achievable voltage on output,
@@ -62,12 +79,40 @@ void PWM_Setup()
 
 void PWM_Tick()
 {
-  PWM_SetDutyCycle(gApp.duty_cycle);
+  // regulator stopped asking for bursts (state or mode changed) - back to the app duty cycle
+  if (burst.active && !burst.requested)
+  {
+    PWM_BurstExit();
+  }
+  burst.requested = false;
+
+  if (pwm.paused)
+  {
+    PWM_SetDutyCycle(0);
+    pwm.paused = false;
+  }
+  else if (burst.active)
+  {
+    PWM_SetDutyCycle(burst.gate_on ? burst.duty : 0);
+  }
+  else
+  {
+    PWM_SetDutyCycle(gApp.duty_cycle);
+  }
+}
+
+void PWM_TimeSlice100ms()
+{
+  optimise_100ms();
 }
 
 void PWM_TimeSlice1000ms()
 {
-  auto_adjust_mode();
+  // efficiency optimiser replaces the fixed high load rule
+  if (!gParams.pwm.optimise)
+  {
+    auto_adjust_mode();
+  }
 }
 /// @brief Set the duty cycle
 /// @param duty_cycle - 0-255 value, 0 off, 255 fully on
@@ -84,8 +129,17 @@ void PWM_SetMode(PWM_MODE_t mode)
 {
   pwm.mode = mode;
 
+  // mode gets applied on resume
+  if (pwm.suspended)
+  {
+    return;
+  }
+
   noInterrupts();
 
+  // TIMER0 clock doubling is only enabled by the doubled modes below, previous mode may have left it on
+  TCKCSR &= ~(1 << TC2XS0);
+
   switch (mode)
   {
   case PWM_MODE_FAST_PWM_15KHZ:
@@ -189,6 +243,13 @@ void PWM_SetMode(PWM_MODE_t mode)
   interrupts();
 }
 
+/// @brief Get PWM mode
+/// @return current mode type
+PWM_MODE_t PWM_GetMode()
+{
+  return pwm.mode;
+}
+
 /// @brief Set PWM output pin drive current
 /// @param current pwm output pin drive current (default is 12mA)
 void PWM_SetOutputCurrent(PWM_OUTPUT_CURRENT_t current)
@@ -207,25 +268,267 @@ void PWM_EnableTimerOverflowInterrupt()
   interrupts();
 }
 
+/// @brief Burst mode (pulse skipping) - at light load switch in bursts gated by hysteresis of the regulated value
+/// and stay off in between, must be called every tick while the regulator wants it
+/// @param load_current output current in mA
+/// @param value regulated value (output voltage in mV or output current in mA)
+/// @param target regulation target, same unit as value
+/// @param hysteresis half-width of the gating window, same unit as value
+/// @return true if converter runs in bursts - regulator must hold the duty cycle
+bool PWM_Burst(uint32_t load_current, uint32_t value, uint32_t target, uint32_t hysteresis)
+{
+  if (!burst.active)
+  {
+    if (!gParams.pwm.burst || load_current >= PWM_BURST_ENTER_CURRENT)
+    {
+      return false;
+    }
+    burst.active = true;
+    burst.gate_on = false;
+    burst.duty = (gApp.duty_cycle + PWM_BURST_DUTY_BOOST < gApp.duty_ceiling) ? gApp.duty_cycle + PWM_BURST_DUTY_BOOST : gApp.duty_ceiling;
+#ifdef DEBUG_MODE
+    Serial.println(F("pwm: burst mode"));
+#endif
+  }
+
+  // load rose or bursts can't keep up - continuous regulation picks up from the held duty cycle
+  if (load_current > PWM_BURST_EXIT_CURRENT || value + PWM_BURST_SAG * hysteresis < target)
+  {
+    PWM_BurstExit();
+    return false;
+  }
+
+  if (value > target + hysteresis)
+  {
+    burst.gate_on = false;
+  }
+  else if (value + hysteresis < target && !burst.gate_on)
+  {
+    burst.gate_on = true;
+    burst.bursts++;
+  }
+  burst.requested = true;
+  return true;
+}
+
+/// @brief Leave burst mode, continuous regulation resumes
+void PWM_BurstExit()
+{
+#ifdef DEBUG_MODE
+  if (burst.active)
+  {
+    Serial.println(F("pwm: continuous mode"));
+  }
+#endif
+  burst.active = false;
+  burst.gate_on = false;
+}
+
+/// @brief Hold the drive off during this tick (i.e. to measure open circuit voltage), must be called every tick
+/// while the pause is needed, so it can't outlive the mode that asked for it
+void PWM_Pause()
+{
+  pwm.paused = true;
+}
+
+/// @brief Check if converter runs in bursts
+/// @return true if burst mode is active
+bool PWM_BurstActive()
+{
+  return burst.active;
+}
+
+/// @brief Get number of bursts started since power up
+/// @return burst count (wraps around)
+uint16_t PWM_BurstCount()
+{
+  return burst.bursts;
+}
+
+/// @brief Stop TIMER0 clock and hold the drive pin low - converter is switched off
+void PWM_Suspend()
+{
+  noInterrupts();
+  // disconnect OC0A and drive the pin low
+  TCCR0A = 0;
+  PORTD &= ~(1 << PORTD6);
+  // stop the clock and its overflow interrupt
+  TCCR0B = 0;
+  TIMSK0 = 0;
+  interrupts();
+  pwm.suspended = true;
+}
+
+/// @brief Restart TIMER0 clock in the current PWM mode
+void PWM_Resume()
+{
+  pwm.suspended = false;
+  PWM_SetMode(pwm.mode);
+  PWM_EnableTimerOverflowInterrupt();
+}
+
 // Auto adjust mode (switching frequency)
 static void auto_adjust_mode()
 {
-  // if duty cycle is max and device is in step down mode - activate high load PWM mode
+  // nothing to adjust while converter is switched off
+  if (pwm.suspended)
+  {
+    return;
+  }
+
+  // if duty cycle is at its ceiling and device is in step down mode - activate high load PWM mode
   // activating it in step-up mode doesn't make sense as the output ripple voltages are too high
-  if (pwm.mode == PWM_MODE_DEFAULT && gApp.duty_cycle == MAX_DUTY_CYCLE  && (gApp.input_voltage > gApp.output_voltage + PWM_STEP_UP_STEP_DOWN_HYSTERESIS))
+  if (pwm.mode == gParams.pwm.mode && gApp.duty_cycle >= gApp.duty_ceiling && (gApp.input_voltage > gApp.output_voltage + PWM_STEP_UP_STEP_DOWN_HYSTERESIS))
   {
-    PWM_SetMode(PWM_STEP_DOWN_MODE_HIGH_LOAD);
+    PWM_SetMode(gParams.pwm.high_load_mode);
 #ifdef DEBUG_MODE
     Serial.println(F("PWM_STEP_DOWN_MODE_HIGH_LOAD"));
 #endif
   }
   // if no high load detected - go back to default PWM mode
-  if (pwm.mode == PWM_STEP_DOWN_MODE_HIGH_LOAD && gApp.duty_cycle <= PWM_HIGH_LOAD_DISABLE)
+  if (pwm.mode == gParams.pwm.high_load_mode && pwm.mode != gParams.pwm.mode && gApp.duty_cycle <= PWM_HIGH_LOAD_DISABLE)
   {
     // set mode to default
-    PWM_SetMode(PWM_MODE_DEFAULT);
+    PWM_SetMode(gParams.pwm.mode);
 #ifdef DEBUG_MODE
     Serial.println(F("PWM_MODE_DEFAULT"));
 #endif
   }
-}
\ No newline at end of file
+}
+
+// Efficiency optimiser - measure efficiency of the candidate frequencies at current operating point and settle on the best one
+static void optimise_100ms()
+{
+  uint32_t input_power = (gApp.input_voltage * gApp.input_current) / 1000;
+
+  // nothing to optimise
+  if (!gParams.pwm.optimise || pwm.suspended || !gSettings.output || gSettings.mode == APP_MODE_CALIBRATION)
+  {
+    // measurement interrupted - go back to the mode used before
+    if (optimiser.state == PWM_OPTIMISER_SETTLE || optimiser.state == PWM_OPTIMISER_MEASURE)
+    {
+      PWM_SetMode(optimiser.initial_mode);
+    }
+    optimiser.state = PWM_OPTIMISER_IDLE;
+    return;
+  }
+
+  optimiser.time_100ms++;
+
+  switch (optimiser.state)
+  {
+  case PWM_OPTIMISER_IDLE:
+    if (input_power >= PWM_OPTIMISER_MIN_POWER)
+    {
+      optimiser_start();
+    }
+    break;
+  case PWM_OPTIMISER_SETTLE:
+    if (optimiser.time_100ms >= PWM_OPTIMISER_SETTLE_100MS)
+    {
+      optimiser.state = PWM_OPTIMISER_MEASURE;
+      optimiser.time_100ms = 0;
+      optimiser.input_power = 0;
+      optimiser.output_power = 0;
+      optimiser.output_voltage_min = UINT16_MAX;
+      optimiser.output_voltage_max = 0;
+    }
+    break;
+  case PWM_OPTIMISER_MEASURE:
+    optimiser.input_power += input_power;
+    optimiser.output_power += (gApp.output_voltage * gApp.output_current) / 1000;
+    if (gApp.output_voltage < optimiser.output_voltage_min)
+    {
+      optimiser.output_voltage_min = gApp.output_voltage;
+    }
+    if (gApp.output_voltage > optimiser.output_voltage_max)
+    {
+      optimiser.output_voltage_max = gApp.output_voltage;
+    }
+    if (optimiser.time_100ms >= PWM_OPTIMISER_WINDOW_100MS)
+    {
+      optimiser_evaluate();
+    }
+    break;
+  case PWM_OPTIMISER_HOLD:
+    // measure again after a while, when load changed or when someone else changed the mode
+    if (optimiser.time_100ms >= PWM_OPTIMISER_HOLD_100MS || operating_point_changed() || pwm.mode != optimiser.best_mode)
+    {
+      optimiser.state = PWM_OPTIMISER_IDLE;
+    }
+    break;
+  }
+}
+
+// Start measuring the candidates
+static void optimiser_start()
+{
+  optimiser.initial_mode = pwm.mode;
+  optimiser.best_mode = pwm.mode;
+  optimiser.best_efficiency = 0;
+  optimiser.initial_efficiency = 0;
+  optimiser.output_current = gApp.output_current;
+  optimiser.candidate = 0;
+  optimiser_apply((PWM_MODE_t)pgm_read_byte(&optimiserCandidates[0]));
+}
+
+// Switch to the mode and let it settle
+static void optimiser_apply(PWM_MODE_t mode)
+{
+  PWM_SetMode(mode);
+  optimiser.state = PWM_OPTIMISER_SETTLE;
+  optimiser.time_100ms = 0;
+}
+
+// Score the measured candidate and move on to the next one, or settle on the best one
+static void optimiser_evaluate()
+{
+  uint16_t ripple = optimiser.output_voltage_max - optimiser.output_voltage_min;
+  uint16_t efficiency = 0;
+
+  if (optimiser.input_power > 0)
+  {
+    efficiency = (optimiser.output_power * 1000) / optimiser.input_power;
+  }
+  if (pwm.mode == optimiser.initial_mode)
+  {
+    optimiser.initial_efficiency = efficiency;
+  }
+  if (ripple <= PWM_OPTIMISER_MAX_RIPPLE && efficiency > optimiser.best_efficiency)
+  {
+    optimiser.best_efficiency = efficiency;
+    optimiser.best_mode = pwm.mode;
+  }
+#ifdef DEBUG_MODE
+  Serial.print(F("pwm optimiser: mode "));
+  Serial.print(pwm.mode);
+  Serial.print(F(" efficiency "));
+  Serial.print(efficiency);
+  Serial.print(F(" ripple "));
+  Serial.println(ripple);
+#endif
+
+  if (++optimiser.candidate < PWM_OPTIMISER_CANDIDATES)
+  {
+    optimiser_apply((PWM_MODE_t)pgm_read_byte(&optimiserCandidates[optimiser.candidate]));
+    return;
+  }
+
+  // hysteresis - keep the mode used before unless the best one is noticeably better
+  if (optimiser.initial_efficiency > 0 && optimiser.best_efficiency < optimiser.initial_efficiency + PWM_OPTIMISER_HYSTERESIS)
+  {
+    optimiser.best_mode = optimiser.initial_mode;
+  }
+  PWM_SetMode(optimiser.best_mode);
+  optimiser.state = PWM_OPTIMISER_HOLD;
+  optimiser.time_100ms = 0;
+}
+
+// Check if output current moved away from the one the mode was chosen for
+static bool operating_point_changed()
+{
+  uint32_t margin = optimiser.output_current / PWM_OPTIMISER_OPERATING_POINT_DIV;
+
+  return (gApp.output_current > optimiser.output_current + margin) ||
+         (gApp.output_current + margin < optimiser.output_current);
+}
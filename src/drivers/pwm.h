@@ -39,6 +39,73 @@ typedef enum PWM_MODE_t PWM_MODE_t;
 // Define duty cycle threshold for deactivating high load mode
 #define PWM_HIGH_LOAD_DISABLE (MAX_DUTY_CYCLE / 10)
 
+// Efficiency optimiser - minimum input power in mW to run (efficiency readings are too noisy below)
+#define PWM_OPTIMISER_MIN_POWER 300
+// Efficiency optimiser - time in 100ms to let the regulation settle after switching frequency
+#define PWM_OPTIMISER_SETTLE_100MS 5
+// Efficiency optimiser - measurement window in 100ms per candidate
+#define PWM_OPTIMISER_WINDOW_100MS 10
+// Efficiency optimiser - time in 100ms to keep the chosen frequency before measuring again
+#define PWM_OPTIMISER_HOLD_100MS 600 // 600*100ms = 60s
+// Efficiency optimiser - efficiency gain in 0.1% required to leave the frequency used before measurement
+#define PWM_OPTIMISER_HYSTERESIS 10 // 1%
+// Efficiency optimiser - max output voltage ripple in mV within window, noisier candidates are rejected
+#define PWM_OPTIMISER_MAX_RIPPLE TO_MILI(0.5)
+// Efficiency optimiser - operating point change (1/x of output current) that triggers new measurement
+#define PWM_OPTIMISER_OPERATING_POINT_DIV 4
+
+// Burst mode - output current in mA below which the converter runs in bursts
+#define PWM_BURST_ENTER_CURRENT 15
+// Burst mode - output current in mA above which continuous regulation is resumed
+#define PWM_BURST_EXIT_CURRENT 30
+// Burst mode - output voltage hysteresis in mV gating the bursts in voltage regulation
+#define PWM_BURST_VOLTAGE_HYSTERESIS TO_MILI(0.1)
+// Burst mode - output current hysteresis (1/x of the target current) gating the bursts in current regulation
+#define PWM_BURST_CURRENT_HYSTERESIS_DIV 4
+// Burst mode - min output current hysteresis in mA, must stay below the lowest current target so bursts can gate on
+#define PWM_BURST_MIN_CURRENT_HYSTERESIS 1
+// Burst mode - duty cycle added on top of the held duty cycle during a burst, so the output rises
+#define PWM_BURST_DUTY_BOOST 3
+// Burst mode - regulated value sagging this many hysteresis widths below target ends burst mode
+#define PWM_BURST_SAG 4
+
+// Efficiency optimiser state machine
+enum PwmOptimiserState_t : uint8_t
+{
+    PWM_OPTIMISER_IDLE = 0, // waiting for output to be on with enough load
+    PWM_OPTIMISER_SETTLE,   // candidate frequency applied, waiting for regulation to settle
+    PWM_OPTIMISER_MEASURE,  // measuring efficiency of the candidate frequency
+    PWM_OPTIMISER_HOLD      // best frequency applied, waiting for operating point change
+};
+typedef enum PwmOptimiserState_t PwmOptimiserState_t;
+
+// Efficiency optimiser
+typedef struct
+{
+    PwmOptimiserState_t state;   // state machine state
+    uint8_t candidate;           // index of the candidate being measured
+    PWM_MODE_t initial_mode;     // mode used before measurement
+    PWM_MODE_t best_mode;        // most efficient mode measured
+    uint16_t best_efficiency;    // efficiency of best_mode in 0.1%
+    uint16_t initial_efficiency; // efficiency of initial_mode in 0.1% (0 if not measured)
+    uint16_t time_100ms;         // time spent in current state
+    uint32_t input_power;        // input power sum in mW over the window
+    uint32_t output_power;       // output power sum in mW over the window
+    uint16_t output_voltage_min; // min output voltage in mV within the window
+    uint16_t output_voltage_max; // max output voltage in mV within the window
+    uint32_t output_current;     // output current in mA of the operating point the mode was chosen for
+} PwmOptimiser_t;
+
+// Burst mode (pulse skipping)
+typedef struct
+{
+    bool active;     // converter runs in bursts, regulator holds the duty cycle
+    bool gate_on;    // burst in progress - switching at burst duty cycle
+    bool requested;  // regulator asked for burst mode during this tick
+    uint8_t duty;    // duty cycle used during a burst
+    uint16_t bursts; // bursts started since power up (wraps around)
+} PwmBurst_t;
+
 // PWM output pin drive current
 enum PWM_OUTPUT_CURRENT_t
 {
@@ -51,13 +118,24 @@ typedef enum PWM_OUTPUT_CURRENT_t PWM_OUTPUT_CURRENT_t;
 typedef struct
 {
     PWM_MODE_t mode; // current PWM mode
+    bool suspended;  // TIMER0 clock is stopped and the drive pin is held low
+    bool paused;     // drive is held off during this tick for a measurement, regulation holds its duty cycle
 } Pwm_t;
 
 void PWM_Setup();
 void PWM_SetMode(PWM_MODE_t mode);
+PWM_MODE_t PWM_GetMode();
 void PWM_SetOutputCurrent(PWM_OUTPUT_CURRENT_t current);
 void PWM_Tick();
+void PWM_TimeSlice100ms();
 void PWM_TimeSlice1000ms();
 void PWM_SetDutyCycle(int duty_cycle);
 void PWM_EnableTimerOverflowInterrupt();
+bool PWM_Burst(uint32_t load_current, uint32_t value, uint32_t target, uint32_t hysteresis);
+void PWM_BurstExit();
+void PWM_Pause();
+bool PWM_BurstActive();
+uint16_t PWM_BurstCount();
+void PWM_Suspend();
+void PWM_Resume();
 #endif
\ No newline at end of file
@@ -0,0 +1,222 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+
+#include <Arduino.h>
+
+#include "energy.h"
+#include "app.h"
+#include "settings.h"
+
+// Energy log must fit its EEPROM region
+static_assert(sizeof(EnergyLog_t) <= EEPROM_ENERGY_END_ADDRESS - EEPROM_ENERGY_ADDRESS, "energy log does not fit its EEPROM region");
+
+// Running session
+static EnergySession_t session;
+// Log as stored in EEPROM
+static EnergyLog_t energyLog;
+// Log write could not be queued yet
+static bool savePending = false;
+
+// Local functions
+static void start_session();
+static void end_session();
+static void checkpoint();
+static void record_session(uint64_t charge, uint64_t output_energy, uint64_t input_energy, uint32_t time_10ms);
+static void save();
+static uint16_t efficiency(uint32_t output_energy, uint32_t input_energy);
+
+/// @brief Load energy log
+void ENERGY_Setup()
+{
+  SETTINGS_Read(EEPROM_ENERGY_ADDRESS, &energyLog, sizeof(energyLog));
+  if (energyLog.magic != ENERGY_MAGIC)
+  {
+    memset(&energyLog, 0, sizeof(energyLog));
+    energyLog.magic = ENERGY_MAGIC;
+  }
+  // power was lost during a session - record it as far as it was checkpointed
+  if (energyLog.checkpoint_time_10ms > 0)
+  {
+    record_session(energyLog.checkpoint_charge, energyLog.checkpoint_output_energy, energyLog.checkpoint_input_energy,
+                   energyLog.checkpoint_time_10ms);
+    save();
+  }
+}
+
+/// @brief Integrate output charge, output and input energy while output is on, record the session once it ends
+void ENERGY_TimeSlice10ms()
+{
+  bool running = gSettings.output && gSettings.mode != APP_MODE_CALIBRATION;
+
+  if (running && !session.active)
+  {
+    start_session();
+  }
+  else if (!running && session.active)
+  {
+    end_session();
+  }
+
+  if (session.active)
+  {
+    session.charge += gApp.output_current;
+    session.output_energy += (gApp.output_voltage * gApp.output_current) / 1000;
+    session.input_energy += (gApp.input_voltage * gApp.input_current) / 1000;
+    session.time_10ms++;
+    if (session.time_10ms % ENERGY_CHECKPOINT_PERIOD_10MS == 0)
+    {
+      checkpoint();
+    }
+  }
+
+  if (savePending)
+  {
+    save();
+  }
+}
+
+/// @brief Get output charge of the running session
+/// @return charge in mAh
+uint32_t ENERGY_Charge()
+{
+  return session.charge / ENERGY_SAMPLES_PER_HOUR;
+}
+
+/// @brief Get output energy of the running session
+/// @return energy in mWh
+uint32_t ENERGY_OutputEnergy()
+{
+  return session.output_energy / ENERGY_SAMPLES_PER_HOUR;
+}
+
+/// @brief Get input energy of the running session
+/// @return energy in mWh
+uint32_t ENERGY_InputEnergy()
+{
+  return session.input_energy / ENERGY_SAMPLES_PER_HOUR;
+}
+
+/// @brief Get efficiency of the running session
+/// @return efficiency in 0.1%
+uint16_t ENERGY_Efficiency()
+{
+  // full resolution sums, so efficiency is available before the first mWh
+  return (session.input_energy > 0) ? (session.output_energy * 1000) / session.input_energy : 0;
+}
+
+/// @brief Print running session, last recorded session and totals
+void ENERGY_Print()
+{
+  Serial.print(F("session: mah="));
+  Serial.print(ENERGY_Charge());
+  Serial.print(F(" mwh="));
+  Serial.print(ENERGY_OutputEnergy());
+  Serial.print(F(" mwh_in="));
+  Serial.print(ENERGY_InputEnergy());
+  Serial.print(F(" eff="));
+  Serial.print(ENERGY_Efficiency());
+  Serial.print(F(" s="));
+  Serial.println(session.time_10ms / 100);
+
+  Serial.print(F("last: mah="));
+  Serial.print(energyLog.charge);
+  Serial.print(F(" mwh="));
+  Serial.print(energyLog.output_energy);
+  Serial.print(F(" mwh_in="));
+  Serial.print(energyLog.input_energy);
+  Serial.print(F(" eff="));
+  Serial.print(efficiency(energyLog.output_energy, energyLog.input_energy));
+  Serial.print(F(" s="));
+  Serial.println(energyLog.duration);
+
+  Serial.print(F("total: sessions="));
+  Serial.print(energyLog.sessions);
+  Serial.print(F(" mwh="));
+  Serial.print((uint32_t)(energyLog.total_output_energy / ENERGY_SAMPLES_PER_HOUR));
+  Serial.print(F(" mwh_in="));
+  Serial.print((uint32_t)(energyLog.total_input_energy / ENERGY_SAMPLES_PER_HOUR));
+  Serial.print(F(" eff="));
+  Serial.println((energyLog.total_input_energy > 0) ? (uint16_t)((energyLog.total_output_energy * 1000) / energyLog.total_input_energy) : 0);
+}
+
+/// @brief Clear recorded sessions and totals
+void ENERGY_Clear()
+{
+  memset(&energyLog, 0, sizeof(energyLog));
+  energyLog.magic = ENERGY_MAGIC;
+  save();
+}
+
+// Start counting new session
+static void start_session()
+{
+  session.active = true;
+  session.charge = 0;
+  session.output_energy = 0;
+  session.input_energy = 0;
+  session.time_10ms = 0;
+}
+
+// Record finished session and add it to the totals, counters are kept until the next session starts
+static void end_session()
+{
+  session.active = false;
+  record_session(session.charge, session.output_energy, session.input_energy, session.time_10ms);
+  save();
+#ifdef DEBUG_MODE
+  Serial.print(F("energy: session ended, mwh="));
+  Serial.println(energyLog.output_energy);
+#endif
+}
+
+// Store running session sums, so they survive a power loss
+static void checkpoint()
+{
+  energyLog.checkpoint_charge = session.charge;
+  energyLog.checkpoint_output_energy = session.output_energy;
+  energyLog.checkpoint_input_energy = session.input_energy;
+  energyLog.checkpoint_time_10ms = session.time_10ms;
+  save();
+}
+
+// Make session the last one and add it to the totals at full resolution, clears the checkpoint
+static void record_session(uint64_t charge, uint64_t output_energy, uint64_t input_energy, uint32_t time_10ms)
+{
+  energyLog.sessions++;
+  energyLog.charge = charge / ENERGY_SAMPLES_PER_HOUR;
+  energyLog.output_energy = output_energy / ENERGY_SAMPLES_PER_HOUR;
+  energyLog.input_energy = input_energy / ENERGY_SAMPLES_PER_HOUR;
+  energyLog.duration = time_10ms / 100;
+  energyLog.total_output_energy += output_energy;
+  energyLog.total_input_energy += input_energy;
+  energyLog.checkpoint_charge = 0;
+  energyLog.checkpoint_output_energy = 0;
+  energyLog.checkpoint_input_energy = 0;
+  energyLog.checkpoint_time_10ms = 0;
+}
+
+// Queue log write without blocking, retried every 10ms while the write queue is full
+static void save()
+{
+  savePending = !SETTINGS_WriteAsync(EEPROM_ENERGY_ADDRESS, &energyLog, sizeof(energyLog));
+}
+
+// Efficiency in 0.1% of the recorded energies
+static uint16_t efficiency(uint32_t output_energy, uint32_t input_energy)
+{
+  return (input_energy > 0) ? ((uint64_t)output_energy * 1000) / input_energy : 0;
+}
@@ -0,0 +1,68 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <stdint.h>
+
+#include "settings.h"
+
+// Amount of 10ms samples in an hour, converts sums of 10ms samples to mAh / mWh
+#define ENERGY_SAMPLES_PER_HOUR 360000UL
+// Magic value marking initialized energy log
+#define ENERGY_MAGIC 0xE4E8
+// Running session is checkpointed to EEPROM this often (10 minutes), so a power loss loses at most that much,
+// while a long charge costs only a few log writes per hour
+#define ENERGY_CHECKPOINT_PERIOD_10MS 60000UL
+
+// Counters of the running session, integrated every 10ms
+typedef struct
+{
+    bool active;            // output is on and the session is being counted
+    uint64_t charge;        // output current sum in mA*10ms
+    uint64_t output_energy; // output power sum in mW*10ms
+    uint64_t input_energy;  // input power sum in mW*10ms
+    uint32_t time_10ms;     // session duration in 10ms
+} EnergySession_t;
+
+// Energy log
+typedef struct
+{
+    uint64_t total_output_energy;      // output power sum of all sessions in mW*10ms
+    uint64_t total_input_energy;       // input power sum of all sessions in mW*10ms
+    uint64_t checkpoint_charge;        // running session output current sum in mA*10ms at the last checkpoint
+    uint64_t checkpoint_output_energy; // running session output power sum in mW*10ms at the last checkpoint
+    uint64_t checkpoint_input_energy;  // running session input power sum in mW*10ms at the last checkpoint
+    uint32_t checkpoint_time_10ms;     // running session duration in 10ms at the last checkpoint (0 - no session running)
+    uint16_t magic;                    // ENERGY_MAGIC when initialized
+    uint16_t sessions;                 // amount of sessions recorded
+    uint32_t charge;                   // last session output charge in mAh
+    uint32_t output_energy;            // last session output energy in mWh
+    uint32_t input_energy;             // last session input energy in mWh
+    uint32_t duration;                 // last session duration in seconds
+} __attribute__((aligned(EEPROM_ALIGNMENT))) EnergyLog_t;
+
+void ENERGY_Setup();
+void ENERGY_TimeSlice10ms();
+uint32_t ENERGY_Charge();
+uint32_t ENERGY_OutputEnergy();
+uint32_t ENERGY_InputEnergy();
+uint16_t ENERGY_Efficiency();
+void ENERGY_Print();
+void ENERGY_Clear();
+#endif
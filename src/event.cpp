@@ -0,0 +1,78 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#include <Arduino.h>
+
+#include "event.h"
+
+static EventQueue_t queue;
+
+/// @brief Push event to the queue, must be called with interrupts disabled (i.e. from ISR)
+/// @param type event type
+/// @param time_10ms event timestamp
+/// @return false if queue is full and event was dropped
+bool EVENT_PushFromISR(EventType_t type, uint16_t time_10ms)
+{
+  uint8_t head = queue.head;
+  uint8_t next = (head + 1) & EVENT_QUEUE_MASK;
+
+  if (next == queue.tail)
+  {
+    if (queue.dropped < UINT8_MAX)
+    {
+      queue.dropped++;
+    }
+    return false;
+  }
+
+  queue.events[head].type = type;
+  queue.events[head].time_10ms = time_10ms;
+  // publish only after the slot is written
+  queue.head = next;
+  return true;
+}
+
+/// @brief Pop oldest event from the queue, main loop only
+/// @param event output event
+/// @return false if queue is empty
+bool EVENT_Pop(Event_t *event)
+{
+  uint8_t tail = queue.tail;
+
+  if (tail == queue.head)
+  {
+    return false;
+  }
+
+  *event = queue.events[tail];
+  // release the slot only after it is read
+  queue.tail = (tail + 1) & EVENT_QUEUE_MASK;
+  return true;
+}
+
+/// @brief Check if there are events waiting
+/// @return true if queue is not empty
+bool EVENT_Pending()
+{
+  return queue.tail != queue.head;
+}
+
+/// @brief Get amount of dropped events since boot
+/// @return dropped events count (saturates at 255)
+uint8_t EVENT_Dropped()
+{
+  return queue.dropped;
+}
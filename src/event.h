@@ -0,0 +1,59 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef EVENT_H
+#define EVENT_H
+
+#include <stdint.h>
+
+// Event queue length, must be a power of 2
+#define EVENT_QUEUE_SIZE 16
+#define EVENT_QUEUE_MASK (EVENT_QUEUE_SIZE - 1)
+
+static_assert((EVENT_QUEUE_SIZE & EVENT_QUEUE_MASK) == 0, "EVENT_QUEUE_SIZE must be a power of 2");
+
+// Event types
+enum EventType_t : uint8_t
+{
+    EVENT_NONE = 0,           // no event
+    EVENT_TICK_10MS,          // TIMER2 overflow, 10ms passed
+};
+typedef enum EventType_t EventType_t;
+
+// Timestamped event
+typedef struct
+{
+    EventType_t type;   // event type
+    uint16_t time_10ms; // lower 16 bits of SYSTEM_10millis() when event was pushed
+} Event_t;
+
+// Single-producer/single-consumer event ring
+// producer: interrupt handlers (they do not nest, so together they act as a single producer),
+// only TIMER2 overflow pushes events - buttons are polled and debounced in the 10ms slice instead
+// consumer: main loop
+typedef struct
+{
+    Event_t events[EVENT_QUEUE_SIZE]; // event storage
+    volatile uint8_t head;            // next slot to write, only written by producer
+    volatile uint8_t tail;            // next slot to read, only written by consumer
+    volatile uint8_t dropped;         // events dropped due to full queue (saturates)
+} EventQueue_t;
+
+bool EVENT_PushFromISR(EventType_t type, uint16_t time_10ms);
+bool EVENT_Pop(Event_t *event);
+bool EVENT_Pending();
+uint8_t EVENT_Dropped();
+#endif
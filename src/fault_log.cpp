@@ -0,0 +1,195 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#include <Arduino.h>
+
+#include "fault_log.h"
+#include "app.h"
+#include "settings.h"
+#include "system.h"
+#include "drivers/pwm.h"
+
+// Fault log must fit its EEPROM region
+static_assert(sizeof(FaultLogHeader_t) + FAULT_LOG_SIZE * sizeof(FaultRecord_t) <= EEPROM_FAULT_LOG_END_ADDRESS - EEPROM_FAULT_LOG_ADDRESS, "fault log does not fit its EEPROM region");
+
+// Header as stored in EEPROM
+static FaultLogHeader_t header;
+// Record being written to EEPROM
+static FaultRecord_t record;
+// Record waiting for the previous write to finish
+static FaultRecord_t pendingRecord;
+static bool recordPending = false;
+// Header waiting for a free write queue slot
+static bool headerPending = false;
+// Ring buffer of the latest output samples
+static FaultSample_t samples[FAULT_LOG_SAMPLES];
+static uint8_t samplesIndex = 0;
+
+// Local functions
+static void flush();
+static uint16_t record_address(uint16_t index);
+static void print_record(FaultRecord_t *faultRecord);
+
+/// @brief Load fault log header
+void FAULT_LOG_Setup()
+{
+  SETTINGS_Read(EEPROM_FAULT_LOG_ADDRESS, &header, sizeof(header));
+  if (header.magic != FAULT_LOG_MAGIC)
+  {
+    header.magic = FAULT_LOG_MAGIC;
+    header.count = 0;
+  }
+}
+
+void FAULT_LOG_TimeSlice10ms()
+{
+  // keep history of the latest output samples
+  samples[samplesIndex].output_voltage = gApp.output_voltage;
+  samples[samplesIndex].output_current = gApp.output_current;
+  samplesIndex = (samplesIndex + 1) % FAULT_LOG_SAMPLES;
+
+  // retry writes that did not fit the write queue
+  if (recordPending || headerPending)
+  {
+    flush();
+  }
+}
+
+/// @brief Snapshot app state and schedule it to be written to EEPROM without blocking
+/// @param cause fault cause
+void FAULT_LOG_Record(FaultCause_t cause)
+{
+  // earlier fault is still waiting for the writer - keep it, it is the root cause
+  if (recordPending)
+  {
+    return;
+  }
+
+  FaultRecord_t *snapshot = &pendingRecord;
+  snapshot->time_10ms = SYSTEM_10millis();
+  snapshot->cause = cause;
+  snapshot->mode = gSettings.mode;
+  snapshot->mode_state = APP_ModeState();
+  snapshot->pwm_mode = PWM_GetMode();
+  snapshot->duty_cycle = gApp.duty_cycle;
+  snapshot->output = gSettings.output;
+  snapshot->input_voltage = gApp.input_voltage;
+  snapshot->output_voltage = gApp.output_voltage;
+  snapshot->input_current = gApp.input_current;
+  snapshot->output_current = gApp.output_current;
+  for (uint8_t i = 0; i < FAULT_LOG_SAMPLES; i++)
+  {
+    snapshot->samples[i] = samples[(samplesIndex + i) % FAULT_LOG_SAMPLES];
+  }
+
+  recordPending = true;
+  flush();
+}
+
+/// @brief Print stored faults, newest first
+void FAULT_LOG_Print()
+{
+  FaultRecord_t faultRecord;
+  uint16_t stored = (header.count < FAULT_LOG_SIZE) ? header.count : FAULT_LOG_SIZE;
+
+  Serial.print(F("faults: "));
+  Serial.println(header.count);
+
+  for (uint16_t i = 1; i <= stored; i++)
+  {
+    SETTINGS_Read(record_address((header.count - i) % FAULT_LOG_SIZE), &faultRecord, sizeof(faultRecord));
+    print_record(&faultRecord);
+  }
+}
+
+/// @brief Clear fault log
+void FAULT_LOG_Clear()
+{
+  header.count = 0;
+  recordPending = false;
+  headerPending = true;
+  flush();
+}
+
+// Queue pending record and header writes, once the writer no longer uses the buffers and has room for them
+static void flush()
+{
+  if (SETTINGS_WriteInProgress(&record, sizeof(record)) || SETTINGS_WriteInProgress(&header, sizeof(header)))
+  {
+    return;
+  }
+
+  if (recordPending)
+  {
+    if (SETTINGS_WriteFree() < 2)
+    {
+      return;
+    }
+    // write the record first and the header after, so interrupted write never points at a partial record
+    record = pendingRecord;
+    SETTINGS_WriteAsync(record_address(header.count % FAULT_LOG_SIZE), &record, sizeof(record));
+    header.count++;
+    SETTINGS_WriteAsync(EEPROM_FAULT_LOG_ADDRESS, &header, sizeof(header));
+    recordPending = false;
+    headerPending = false;
+  }
+  else if (headerPending)
+  {
+    headerPending = !SETTINGS_WriteAsync(EEPROM_FAULT_LOG_ADDRESS, &header, sizeof(header));
+  }
+}
+
+// EEPROM address of the record slot
+static uint16_t record_address(uint16_t index)
+{
+  return EEPROM_FAULT_LOG_ADDRESS + sizeof(FaultLogHeader_t) + index * sizeof(FaultRecord_t);
+}
+
+// Print single fault record
+static void print_record(FaultRecord_t *faultRecord)
+{
+  Serial.print(F("t="));
+  Serial.print(faultRecord->time_10ms);
+  Serial.print(F(" cause="));
+  Serial.print(faultRecord->cause);
+  Serial.print(F(" mode="));
+  Serial.print(faultRecord->mode);
+  Serial.print(F(" state="));
+  Serial.print(faultRecord->mode_state);
+  Serial.print(F(" pwm="));
+  Serial.print(faultRecord->pwm_mode);
+  Serial.print(F(" out="));
+  Serial.print(faultRecord->output);
+  Serial.print(F(" duty="));
+  Serial.print(faultRecord->duty_cycle);
+  Serial.print(F(" vin="));
+  Serial.print(faultRecord->input_voltage);
+  Serial.print(F(" iin="));
+  Serial.print(faultRecord->input_current);
+  Serial.print(F(" vout="));
+  Serial.print(faultRecord->output_voltage);
+  Serial.print(F(" iout="));
+  Serial.print(faultRecord->output_current);
+  Serial.print(F(" samples="));
+  for (uint8_t i = 0; i < FAULT_LOG_SAMPLES; i++)
+  {
+    Serial.print(faultRecord->samples[i].output_voltage);
+    Serial.print('/');
+    Serial.print(faultRecord->samples[i].output_current);
+    Serial.print(' ');
+  }
+  Serial.println();
+}
@@ -0,0 +1,83 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef FAULT_LOG_H
+#define FAULT_LOG_H
+
+#include <stdint.h>
+
+#include "settings.h"
+
+// Amount of fault records kept in EEPROM (the oldest gets overwritten)
+#define FAULT_LOG_SIZE 4
+// Amount of output samples (taken every 10ms) leading up to the fault stored in each record
+#define FAULT_LOG_SAMPLES 4
+// Magic value marking initialized fault log header
+#define FAULT_LOG_MAGIC 0xFA17
+
+// Fault cause
+enum FaultCause_t : uint8_t
+{
+    FAULT_CAUSE_NONE = 0,              // no fault
+    FAULT_CAUSE_INPUT_OVERCURRENT,     // input current overload over MAX_INPUT_CURRENT
+    FAULT_CAUSE_OUTPUT_OVERCURRENT,    // output current overload over MAX_OUTPUT_CURRENT
+    FAULT_CAUSE_OUTPUT_OVERVOLTAGE,    // output voltage overload over MAX_OUTPUT_VOLTAGE
+    FAULT_CAUSE_NO_OUTPUT,             // duty cycle at its ceiling, but output voltage below minimum (broken mosfet etc.)
+    FAULT_CAUSE_DIODE_REVERSE_VOLTAGE, // Vin+Vout over SEPIC diode reverse voltage budget
+    FAULT_CAUSE_OVER_TEMPERATURE,      // power stage temperature over THERMAL_SHUTDOWN
+    FAULT_CAUSE_PRECHARGE,             // deeply discharged battery did not recover during pre-charge
+    FAULT_CAUSE_MAX                    // not used
+};
+typedef enum FaultCause_t FaultCause_t;
+
+// Output sample taken before the fault
+typedef struct
+{
+    uint16_t output_voltage; // output voltage in mV
+    uint16_t output_current; // output current in mA
+} FaultSample_t;
+
+// Fault record
+typedef struct
+{
+    uint32_t time_10ms;                       // uptime in 10ms when fault happened
+    FaultCause_t cause;                       // fault cause
+    AppMode_t mode;                           // app mode
+    uint8_t mode_state;                       // app mode state machine state
+    uint8_t pwm_mode;                         // PWM mode
+    uint8_t duty_cycle;                       // duty cycle
+    uint8_t output;                           // output flag
+    uint16_t input_voltage;                   // input voltage in mV
+    uint16_t output_voltage;                  // output voltage in mV
+    uint16_t input_current;                   // input current in mA
+    uint16_t output_current;                  // output current in mA
+    FaultSample_t samples[FAULT_LOG_SAMPLES]; // output samples leading up to the fault (oldest first)
+} __attribute__((aligned(EEPROM_ALIGNMENT))) FaultRecord_t;
+
+// Fault log header
+typedef struct
+{
+    uint16_t magic; // FAULT_LOG_MAGIC when initialized
+    uint16_t count; // total amount of faults recorded
+} __attribute__((aligned(EEPROM_ALIGNMENT))) FaultLogHeader_t;
+
+void FAULT_LOG_Setup();
+void FAULT_LOG_TimeSlice10ms();
+void FAULT_LOG_Record(FaultCause_t cause);
+void FAULT_LOG_Print();
+void FAULT_LOG_Clear();
+
+#endif
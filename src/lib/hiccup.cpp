@@ -0,0 +1,66 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+
+#include "hiccup.h"
+
+/// @brief Initialize hiccup foldback, output is allowed on
+/// @param hiccup pointer to hiccup struct
+/// @param now_10ms current time in 10ms
+void HICCUP_Init(Hiccup_t *hiccup, uint16_t now_10ms)
+{
+    hiccup->off = false;
+    hiccup->since_10ms = now_10ms;
+    hiccup->count = 0;
+}
+
+/// @brief Turn the output off once short circuit lasted detect time, retry after off time
+/// @param hiccup pointer to hiccup struct
+/// @param shorted short circuit condition seen by the regulator
+/// @param detect_10ms time in 10ms the short circuit has to last
+/// @param off_10ms time in 10ms the output is held off
+/// @param now_10ms current time in 10ms
+/// @return action for the regulator
+HiccupAction_t HICCUP_Update(Hiccup_t *hiccup, bool shorted, uint16_t detect_10ms, uint16_t off_10ms, uint16_t now_10ms)
+{
+    uint16_t elapsed = now_10ms - hiccup->since_10ms;
+
+    if (hiccup->off)
+    {
+        if (elapsed < off_10ms)
+        {
+            return HICCUP_OFF;
+        }
+        hiccup->off = false;
+        hiccup->since_10ms = now_10ms;
+        return HICCUP_RETRY;
+    }
+
+    if (!shorted)
+    {
+        hiccup->since_10ms = now_10ms;
+        return HICCUP_RUN;
+    }
+
+    if (elapsed >= detect_10ms)
+    {
+        hiccup->off = true;
+        hiccup->since_10ms = now_10ms;
+        hiccup->count++;
+        return HICCUP_OFF;
+    }
+    return HICCUP_RUN;
+}
@@ -0,0 +1,47 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+
+#ifndef HICCUP_H
+#define HICCUP_H
+
+#include <stdint.h>
+
+// Time in 10ms the short circuit has to last before the output is turned off
+#define HICCUP_DETECT_10MS 2
+// Output current (percentage of the regulator current limit) considered at the limit
+#define HICCUP_CURRENT_PCT 80
+
+// Hiccup short circuit foldback action requested from the regulator
+enum HiccupAction_t : uint8_t
+{
+    HICCUP_RUN = 0, // regulate normally
+    HICCUP_OFF,     // keep the output off
+    HICCUP_RETRY    // off time elapsed, restart through soft start
+};
+typedef enum HiccupAction_t HiccupAction_t;
+
+// Hiccup short circuit foldback
+typedef struct
+{
+    bool off;            // output is held off after a short circuit
+    uint16_t since_10ms; // lower 16 bits of SYSTEM_10millis() when short circuit started or output went off
+    uint16_t count;      // hiccups since init (wraps around)
+} Hiccup_t;
+
+void HICCUP_Init(Hiccup_t *hiccup, uint16_t now_10ms);
+HiccupAction_t HICCUP_Update(Hiccup_t *hiccup, bool shorted, uint16_t detect_10ms, uint16_t off_10ms, uint16_t now_10ms);
+#endif
@@ -0,0 +1,78 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+
+#include "peak_detect.h"
+
+/// @brief Initialize peak detector
+/// @param detect pointer to peak detector struct
+/// @param shift filter strength, each sample moves the filtered value by 1/2^shift of the difference
+void PEAK_DETECT_Init(PeakDetect_t *detect, uint8_t shift)
+{
+    detect->filtered = 0;
+    detect->peak = 0;
+    detect->since_peak = 0;
+    detect->samples = 0;
+    detect->shift = shift;
+}
+
+/// @brief Filter new sample and track the peak of the filtered signal
+/// @param detect pointer to peak detector struct
+/// @param sample new sample
+/// @return filtered value
+uint16_t PEAK_DETECT_Update(PeakDetect_t *detect, uint16_t sample)
+{
+    uint32_t scaled = (uint32_t)sample << PEAK_DETECT_FRACTION_BITS;
+    uint16_t value;
+
+    // first sample initializes the filter, so it doesn't have to rise from 0
+    if (detect->samples == 0)
+    {
+        detect->filtered = scaled;
+    }
+    else if (scaled > detect->filtered)
+    {
+        detect->filtered += (scaled - detect->filtered) >> detect->shift;
+    }
+    else
+    {
+        detect->filtered -= (detect->filtered - scaled) >> detect->shift;
+    }
+    if (detect->samples < UINT16_MAX)
+    {
+        detect->samples++;
+    }
+
+    value = detect->filtered >> PEAK_DETECT_FRACTION_BITS;
+    if (value > detect->peak)
+    {
+        detect->peak = value;
+        detect->since_peak = 0;
+    }
+    else if (detect->since_peak < UINT16_MAX)
+    {
+        detect->since_peak++;
+    }
+    return value;
+}
+
+/// @brief Get drop of the filtered signal below its peak
+/// @param detect pointer to peak detector struct
+/// @return peak minus filtered value
+uint16_t PEAK_DETECT_Drop(const PeakDetect_t *detect)
+{
+    return detect->peak - (detect->filtered >> PEAK_DETECT_FRACTION_BITS);
+}
@@ -0,0 +1,39 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+
+#ifndef PEAK_DETECT_H
+#define PEAK_DETECT_H
+
+#include <stdint.h>
+
+// Fractional bits of the filtered value, keeps slow filtering from stalling on integer truncation
+#define PEAK_DETECT_FRACTION_BITS 8
+
+// Peak detector of a slowly filtered signal
+typedef struct
+{
+    uint32_t filtered;   // filtered sample with PEAK_DETECT_FRACTION_BITS fractional bits
+    uint16_t peak;       // highest filtered sample
+    uint16_t since_peak; // samples since the peak last rose
+    uint16_t samples;    // samples taken (saturates)
+    uint8_t shift;       // filter strength, each sample moves the filtered value by 1/2^shift of the difference
+} PeakDetect_t;
+
+void PEAK_DETECT_Init(PeakDetect_t *detect, uint8_t shift);
+uint16_t PEAK_DETECT_Update(PeakDetect_t *detect, uint16_t sample);
+uint16_t PEAK_DETECT_Drop(const PeakDetect_t *detect);
+#endif
@@ -0,0 +1,66 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+
+#include "ramp.h"
+
+/// @brief Initialize ramp, active setpoint jumps to the value
+/// @param ramp pointer to ramp struct
+/// @param value initial setpoint
+/// @param rate max change of the active setpoint per 10ms (0 - no limit)
+/// @param now_10ms current time in 10ms
+void RAMP_Init(Ramp_t *ramp, uint32_t value, uint16_t rate, uint16_t now_10ms)
+{
+    ramp->value = value;
+    ramp->target = value;
+    ramp->rate = rate;
+    ramp->last_10ms = now_10ms;
+}
+
+/// @brief Request new setpoint, active setpoint moves toward it on updates
+/// @param ramp pointer to ramp struct
+/// @param target requested setpoint
+void RAMP_SetTarget(Ramp_t *ramp, uint32_t target)
+{
+    ramp->target = target;
+}
+
+/// @brief Move active setpoint toward the requested one by rate for every 10ms elapsed since last update
+/// @param ramp pointer to ramp struct
+/// @param now_10ms current time in 10ms
+/// @return active setpoint
+uint32_t RAMP_Update(Ramp_t *ramp, uint16_t now_10ms)
+{
+    uint16_t elapsed = now_10ms - ramp->last_10ms;
+    uint32_t step = (uint32_t)ramp->rate * elapsed;
+
+    ramp->last_10ms = now_10ms;
+
+    // no limit - jump
+    if (ramp->rate == 0)
+    {
+        ramp->value = ramp->target;
+    }
+    else if (ramp->value < ramp->target)
+    {
+        ramp->value = (ramp->target - ramp->value > step) ? ramp->value + step : ramp->target;
+    }
+    else if (ramp->value > ramp->target)
+    {
+        ramp->value = (ramp->value - ramp->target > step) ? ramp->value - step : ramp->target;
+    }
+    return ramp->value;
+}
@@ -0,0 +1,35 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+
+#ifndef RAMP_H
+#define RAMP_H
+
+#include <stdint.h>
+
+// Slew-rate limited setpoint
+typedef struct
+{
+    uint32_t value;     // active setpoint
+    uint32_t target;    // requested setpoint
+    uint16_t rate;      // max change of the active setpoint per 10ms (0 - no limit)
+    uint16_t last_10ms; // lower 16 bits of SYSTEM_10millis() at the last update
+} Ramp_t;
+
+void RAMP_Init(Ramp_t *ramp, uint32_t value, uint16_t rate, uint16_t now_10ms);
+void RAMP_SetTarget(Ramp_t *ramp, uint32_t target);
+uint32_t RAMP_Update(Ramp_t *ramp, uint16_t now_10ms);
+#endif
@@ -21,7 +21,11 @@
 #include "cc_mode.h"
 #include "cv_mode.h"
 #include "app.h"
+#include "drivers/button.h"
 #include "drivers/led.h"
+#include "params.h"
+#include "setpoint.h"
+#include "thermal.h"
 #include "settings.h"
 #include "system.h"
 
@@ -30,6 +34,8 @@ static void protect(CcMode_t *ccMode);
 static void soft_start(CcMode_t *ccMode);
 static void snub(CcMode_t *ccMode);
 static void turn_on(CcMode_t *ccMode);
+static void apply_setting();
+static bool hiccup(CcMode_t *ccMode, uint32_t target_current);
 static void init_leds();
 static void toggle_leds();
 
@@ -52,20 +58,27 @@ void CC_MODE_Init()
   // Setup CC mode
   gApp.duty_cycle = 0;
   ccModeLocal.current = CC_MODE_CurrentSettingToMa(gSettings.cc_mode.current);
-  ccModeLocal.max_current_ripple = TO_MILI(1.0);
-  ccModeLocal.soft_start_step_up_current = TO_MILI(0.001);
-  ccModeLocal.soft_start_period_10ms = 5; // 5 -> 5*10ms=50ms
-  ccModeLocal.snub_power = 3;
+  ccModeLocal.max_current_ripple = gParams.cc_mode.max_current_ripple;
+  ccModeLocal.soft_start_step_up_current = gParams.cc_mode.soft_start_step_up_current;
+  ccModeLocal.soft_start_period_10ms = gParams.cc_mode.soft_start_period_10ms;
+  ccModeLocal.snub_power = gParams.cc_mode.snub_power;
   ccModeLocal.internal_var.previous_current = MAX_OUTPUT_CURRENT;
-  ccModeLocal.cv_mode_switch_hysteresis = 0;
+  ccModeLocal.cv_mode_switch_hysteresis = gParams.cc_mode.cv_mode_switch_hysteresis;
+  ccModeLocal.hiccup_off_10ms = gParams.cc_mode.hiccup_off_10ms;
+  HICCUP_Init(&ccModeLocal.internal_var.hiccup, SYSTEM_10millis());
+  RAMP_Init(&ccModeLocal.internal_var.current_ramp, ccModeLocal.current, gParams.cc_mode.slew_rate, SYSTEM_10millis());
   soft_start(&ccModeLocal);
 
   // Setup CV mode
   ccModeLocal.internal_var.cv_mode.voltage = CV_MODE_VoltageSettingToMv(gSettings.cc_mode.voltage);
-  ccModeLocal.internal_var.cv_mode.max_voltage_ripple = TO_MILI(2.0);
-  ccModeLocal.internal_var.cv_mode.snub_power = 3;
-  ccModeLocal.internal_var.cv_mode.soft_start_period_10ms = 5; // 5 -> 5*10ms=50ms
+  ccModeLocal.internal_var.cv_mode.max_voltage_ripple = gParams.cc_mode.cv_max_voltage_ripple;
+  ccModeLocal.internal_var.cv_mode.snub_power = gParams.cv_mode.snub_power;
+  ccModeLocal.internal_var.cv_mode.cable_resistance = 0;
+  // voltage limit loop only runs with output voltage at the limit, short circuit is handled by the current loop
+  ccModeLocal.internal_var.cv_mode.hiccup_off_10ms = 0;
+  ccModeLocal.internal_var.cv_mode.soft_start_period_10ms = gParams.cv_mode.soft_start_period_10ms;
   ccModeLocal.internal_var.cv_mode.state = CV_MODE_STATE_ON;
+  RAMP_Init(&ccModeLocal.internal_var.cv_mode.internal_var.voltage_ramp, ccModeLocal.internal_var.cv_mode.voltage, gParams.cv_mode.slew_rate, SYSTEM_10millis());
 
   // clear leds
   LED_Clear();
@@ -85,23 +98,41 @@ void CC_MODE_Regulate(CcMode_t *ccMode)
     return;
   }
 
+  // Get current time
+  ccMode->internal_var.current_time_10ms = SYSTEM_10millis();
+
   // if voltage is higher then desired limit or currently snubbing voltage spike (likely no load connected) do the CV mode loop
   // TODO: Refactor this so CC mode has separate hysteresis param
-  if (gApp.output_voltage >= (ccMode->internal_var.cv_mode.voltage + ccMode->cv_mode_switch_hysteresis) || ccMode->internal_var.cv_mode.state == CV_MODE_STATE_SNUB)
+  // voltage limit follows its setting at limited slew rate, same as in the CV mode loop
+  Ramp_t *limit_ramp = &ccMode->internal_var.cv_mode.internal_var.voltage_ramp;
+  RAMP_SetTarget(limit_ramp, ccMode->internal_var.cv_mode.voltage);
+  // voltage limit is lowered if input voltage rose, so Vin+Vout stays within the diode reverse voltage budget
+  uint32_t limit_voltage = SETPOINT_ClampVoltage(RAMP_Update(limit_ramp, ccMode->internal_var.current_time_10ms));
+  // duty cycle ceiling follows the voltage limit, output can't go above it
+  gApp.target_voltage = limit_voltage;
+  if (gApp.output_voltage >= (limit_voltage + ccMode->cv_mode_switch_hysteresis) || ccMode->internal_var.cv_mode.state == CV_MODE_STATE_SNUB)
   {
     CV_MODE_Regulate(&ccMode->internal_var.cv_mode);
     return;
   }
   // otherwise do the CC loop
 
-  // Get current time
-  ccMode->internal_var.current_time_10ms = SYSTEM_10millis();
+  // move the active target toward the requested one at limited slew rate, so live setting changes don't overshoot
+  RAMP_SetTarget(&ccMode->internal_var.current_ramp, ccMode->current);
+  // lower the target current when power stage gets hot
+  uint32_t target_current = THERMAL_Derate(RAMP_Update(&ccMode->internal_var.current_ramp, ccMode->internal_var.current_time_10ms));
+
+  // dead short - output stays off for a while, then soft start retries, so the load recovers without a reboot
+  if (hiccup(ccMode, target_current))
+  {
+    return;
+  }
 
   // If we are in snub state hold the duty cycle at 0
   if (ccMode->state == CC_MODE_STATE_SNUB)
   {
     // once the current drops to desired snub level
-    if (gApp.output_current < ((ccMode->current * (100 - ccMode->snub_power)) / 100))
+    if (gApp.output_current < ((target_current * (100 - ccMode->snub_power)) / 100))
     {
       // special case when snub power is set to 0, we skip the soft start
       // this might cause oscilations of the output voltage, however might be useful for voltage insensitive loads like motors etc
@@ -122,8 +153,22 @@ void CC_MODE_Regulate(CcMode_t *ccMode)
     }
   }
 
+  // at light load run in bursts, holding the duty cycle so continuous regulation resumes where it left off
+  // low targets (2mA) would round the hysteresis down to 0, then any sag ends burst mode before a burst gates on
+  uint32_t hysteresis = target_current / PWM_BURST_CURRENT_HYSTERESIS_DIV;
+  if (hysteresis < PWM_BURST_MIN_CURRENT_HYSTERESIS)
+  {
+    hysteresis = PWM_BURST_MIN_CURRENT_HYSTERESIS;
+  }
+  if (ccMode->state == CC_MODE_STATE_ON &&
+      PWM_Burst(gApp.output_current, gApp.output_current, target_current, hysteresis))
+  {
+    ccMode->internal_var.previous_current = gApp.output_current;
+    return;
+  }
+
   // if current is below target current and duty cycle can be increased
-  if ((gApp.output_current < ccMode->current) && (gApp.duty_cycle < MAX_DUTY_CYCLE))
+  if ((gApp.output_current < target_current) && (gApp.duty_cycle < gApp.duty_ceiling))
   {
     // if in soft start state
     if (ccMode->state == CC_MODE_STATE_SOFT_START)
@@ -145,7 +190,7 @@ void CC_MODE_Regulate(CcMode_t *ccMode)
     }
   }
   // if output current is too high, and duty cycle can be lowered
-  else if ((gApp.output_current > ccMode->current) && (gApp.duty_cycle > MIN_DUTY_CYCLE))
+  else if ((gApp.output_current > target_current) && (gApp.duty_cycle > MIN_DUTY_CYCLE))
   {
     gApp.duty_cycle -= 1;
     // Disable soft start and turn on
@@ -155,9 +200,9 @@ void CC_MODE_Regulate(CcMode_t *ccMode)
     }
   }
 
-  if ((gApp.output_current >= ccMode->current) || (gApp.duty_cycle == MAX_DUTY_CYCLE))
+  if ((gApp.output_current >= target_current) || (gApp.duty_cycle >= gApp.duty_ceiling))
   {
-    // turn off soft start once the desired current or max duty cycle is reached
+    // turn off soft start once the desired current or duty cycle ceiling is reached
     if (ccMode->state == CC_MODE_STATE_SOFT_START)
     {
       turn_on(ccMode);
@@ -171,6 +216,13 @@ void CC_MODE_Tick()
 {
   CC_MODE_Regulate(&ccModeLocal);
 }
+/// @brief Get CC mode state machine state
+/// @return current state
+CcModeState_t CC_MODE_GetState()
+{
+  return ccModeLocal.state;
+}
+
 void CC_MODE_TimeSlice10ms()
 {
 }
@@ -209,8 +261,7 @@ void CC_MODE_OutputBtnPressed()
   {
     gSettings.cc_mode.current = CC_MODE_CURRENT_2MA;
   }
-  // Re-initialize with new params
-  CC_MODE_Init();
+  apply_setting();
   // Schedule settings save to EEPROM
   gSettingsSaveIn1000ms = SETTINGS_SAVE_DELAY_SECONDS;
 
@@ -220,16 +271,10 @@ void CC_MODE_OutputBtnPressed()
 }
 void CC_MODE_OutputBtnHeld()
 {
-  if (gSettings.cc_mode.voltage < CV_MODE_VOLTAGE_18V)
-  {
-    gSettings.cc_mode.voltage = (CvModeVoltage_t)(gSettings.cc_mode.voltage + 1);
-  }
-  else
-  {
-    gSettings.cc_mode.voltage = CV_MODE_VOLTAGE_1_5V;
-  }
-  // Re-initialize with new params
-  CC_MODE_Init();
+  // skip voltages that would exceed the diode reverse voltage budget at current input voltage
+  // auto-repeat stops at the highest voltage instead of jumping to the lowest
+  gSettings.cc_mode.voltage = SETPOINT_NextVoltageSetting(gSettings.cc_mode.voltage, true, !BUTTON_Repeating(), CV_MODE_VoltageSettingToMv);
+  apply_setting();
   // Schedule settings save to EEPROM
   gSettingsSaveIn1000ms = SETTINGS_SAVE_DELAY_SECONDS;
 #ifdef DEBUG_MODE
@@ -242,9 +287,11 @@ static void protect(CcMode_t *ccMode)
 {
   // if the output current spikes beyond acceptable ouput current ripple (i.e load disconnected abruptly)
   // go to fail mode
-  if (ccMode->state == CC_MODE_STATE_ON)
+  // output is expected to lag above the target while it ramps down
+  Ramp_t *ramp = &ccMode->internal_var.current_ramp;
+  if (ccMode->state == CC_MODE_STATE_ON && ramp->value <= ramp->target)
   {
-    if (gApp.output_current > ccMode->current + ccMode->max_current_ripple)
+    if (gApp.output_current > ramp->value + ccMode->max_current_ripple)
     {
 #ifdef DEBUG_MODE
       Serial.print("cc mode: output overcurrent protection triggered. current reached:  ");
@@ -258,6 +305,22 @@ static void protect(CcMode_t *ccMode)
   }
 }
 
+// Apply changed current or voltage limit setting - live output ramps to the new values, otherwise start over
+static void apply_setting()
+{
+  if (gSettings.output && ccModeLocal.state == CC_MODE_STATE_ON)
+  {
+    ccModeLocal.current = CC_MODE_CurrentSettingToMa(gSettings.cc_mode.current);
+    ccModeLocal.internal_var.cv_mode.voltage = CV_MODE_VoltageSettingToMv(gSettings.cc_mode.voltage);
+    LED_Clear();
+    init_leds();
+  }
+  else
+  {
+    CC_MODE_Init();
+  }
+}
+
 // state machine soft start action
 static void soft_start(CcMode_t *ccMode)
 {
@@ -291,6 +354,33 @@ static void turn_on(CcMode_t *ccMode)
   gLed.needs_update = 1;
 }
 
+// Detect short circuit (output voltage collapsed with output current at its target) and run the hiccup cycle
+static bool hiccup(CcMode_t *ccMode, uint32_t target_current)
+{
+  if (ccMode->hiccup_off_10ms == 0)
+  {
+    return false;
+  }
+
+  bool shorted = (gApp.output_voltage < CC_MODE_SHORT_VOLTAGE) &&
+                 (gApp.output_current >= (target_current * HICCUP_CURRENT_PCT) / 100);
+
+  switch (HICCUP_Update(&ccMode->internal_var.hiccup, shorted, HICCUP_DETECT_10MS, ccMode->hiccup_off_10ms, ccMode->internal_var.current_time_10ms))
+  {
+  case HICCUP_OFF:
+    gApp.duty_cycle = 0;
+    // turn on error LED - indicating that output is shorted
+    gLed.error = 1;
+    gLed.needs_update = 1;
+    return true;
+  case HICCUP_RETRY:
+    soft_start(ccMode);
+    return false;
+  default:
+    return false;
+  }
+}
+
 /// @brief Convert CcModeCurrent_t setting to mA
 /// @param current CcModeCurrent_t setting
 /// @return current in mA
@@ -20,6 +20,9 @@
 #include "cv_mode.h"
 #include "settings.h"
 
+// Hiccup foldback - output voltage in mV below which (with output current at its target) the output is a short circuit
+#define CC_MODE_SHORT_VOLTAGE TO_MILI(0.5)
+
 // CC mode state machine
 enum CcModeState_t : uint8_t
 {
@@ -35,6 +38,8 @@ typedef struct
     uint32_t previous_current;              // stores previous reading of the output current in mA
     unsigned long current_time_10ms;        // stores milis10ms() for current time
     unsigned long last_soft_regulated_10ms; // stores milis10ms() at the time last soft regulation took place
+    Ramp_t current_ramp;                    // active target current in mA, follows current at limited slew rate
+    Hiccup_t hiccup;                        // short circuit hiccup foldback
     CvMode_t cv_mode;                       // CV mode struct
 } CcModeInternalVar_t;
 
@@ -42,17 +47,19 @@ typedef struct
 typedef struct
 {
     CcModeState_t state;                 // cc mode current state
-    uint32_t current;                    // target output current in mA
+    uint32_t current;                    // requested target output current in mA
     uint32_t max_current_ripple;         // max output current ripple in mA, if breached soft start is enabled and duty dropped to 0
     uint32_t soft_start_step_up_current; // define step up in mA during soft start, higher the value the more agressive will be the soft start ramp up
     uint8_t soft_start_period_10ms;      // defines delay in 10ms between soft start regulations, higher delay = slower soft start
     uint8_t snub_power;                  // defines snubbing power which is a target current drop percentage (0-100%)
     uint16_t cv_mode_switch_hysteresis;  // defines hysteresis (in mV) for switching to CV mode if no load connected
+    uint16_t hiccup_off_10ms;            // output off time in 10ms after a short circuit (0 - no hiccup foldback)
     CcModeInternalVar_t internal_var;    // internal variables
 } CcMode_t;
 
 void CC_MODE_Init();
 void CC_MODE_Tick();
+CcModeState_t CC_MODE_GetState();
 void CC_MODE_TimeSlice10ms();
 void CC_MODE_TimeSlice100ms();
 void CC_MODE_TimeSlice500ms();
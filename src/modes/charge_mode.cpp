@@ -22,68 +22,71 @@
 #include "cc_mode.h"
 #include "cv_mode.h"
 #include "app.h"
+#include "drivers/button.h"
 #include "drivers/led.h"
+#include "params.h"
+#include "setpoint.h"
 #include "settings.h"
 #include "system.h"
+#include "drivers/pwm.h"
 
 // Local functions
 static void init_leds();
 static void toggle_config_leds();
 static void toggle_output_status_led();
+static void show_state_of_charge();
 static void start_charging(ChargeMode_t *chargeMode);
+static void start_precharge(ChargeMode_t *chargeMode);
+static void precharge(ChargeMode_t *chargeMode);
 static void standby(ChargeMode_t *chargeMode);
 static void finish_charging(ChargeMode_t *chargeMode);
+static void load_stage(ChargeMode_t *chargeMode, uint8_t index);
+static void apply_stage(ChargeMode_t *chargeMode);
+static void enter_stage(ChargeMode_t *chargeMode, uint8_t index);
+static void run_stage(ChargeMode_t *chargeMode);
+static bool neg_delta_v(ChargeMode_t *chargeMode);
+static void measure_10ms(ChargeMode_t *chargeMode);
+static void compensate_ir(ChargeMode_t *chargeMode);
+static void regulate(ChargeMode_t *chargeMode);
 
 // Local charge mode struct
 static ChargeMode_t chargeModeLocal;
 
-// Map minimum voltages in mV - charging will not start if battery doesn't have such voltage
-static const uint16_t minimumVoltage[] = {
-    TO_MILI(1.1), // alkaline / nimh
-    TO_MILI(2.0), // 3V coin battery?
-    TO_MILI(3.0), // LIPO cell voltage
-    TO_MILI(4.0),
-    TO_MILI(6.0), // 2S LIPO ? 3V×2
-    TO_MILI(10.0),  // 12V car battery
-    TO_MILI(15.0)}; // 18V power tool battery, 3V*5 = 15V
-
-// Map maximum (fully charged) voltages in mV
-static const uint16_t maximumVoltage[] = {
-    TO_MILI(1.48), // alkaline / nimh
-    TO_MILI(3.1),  // 3V coin battery?
-    TO_MILI(4.12), // LIPO cell
-    TO_MILI(5.0),
-    TO_MILI(8.24), // 2S LIPO ? 4,12V×2
-    TO_MILI(13.8),  // 12V car battery
-    TO_MILI(20.0)}; // 18V power tool battery, 4V*5 = 20V
-
 /// @brief Initialize CC mode
 void CHARGE_MODE_Init()
 {
   gApp.duty_cycle = 0;
 
-  // Setup regulation period
-  // in order to have accurate output voltage reading during charging
-  // the regulation loop needs to be slowed down
-  chargeModeLocal.regulation_period_10ms = 7; // 7*10ms = 70ms
+  // Start over from the first stage of the charge profile, it sets the current and voltage limits
+  chargeModeLocal.state = CHARGE_MODE_IDLE;
+  chargeModeLocal.internal_var.open_circuit_voltage = 0;
+  chargeModeLocal.internal_var.resistance = 0;
+  // converter may have been running until now, idle state waits for the voltages to settle
+  chargeModeLocal.internal_var.window_10ms = 0;
+  load_stage(&chargeModeLocal, 0);
 
   // Setup CC mode
-  chargeModeLocal.internal_var.cc_mode.current = CC_MODE_CurrentSettingToMa(gSettings.charge_mode.current);
-  chargeModeLocal.internal_var.cc_mode.max_current_ripple = TO_MILI(1.0);
-  chargeModeLocal.internal_var.cc_mode.soft_start_step_up_current = TO_MILI(0.001);
-  chargeModeLocal.internal_var.cc_mode.soft_start_period_10ms = 5; // 5 -> 5*10ms=50ms
+  chargeModeLocal.internal_var.cc_mode.max_current_ripple = gParams.charge_mode.max_current_ripple;
+  chargeModeLocal.internal_var.cc_mode.soft_start_step_up_current = gParams.cc_mode.soft_start_step_up_current;
+  chargeModeLocal.internal_var.cc_mode.soft_start_period_10ms = gParams.cc_mode.soft_start_period_10ms;
   chargeModeLocal.internal_var.cc_mode.snub_power = 0;
-  chargeModeLocal.internal_var.cc_mode.cv_mode_switch_hysteresis = 20; // 20mV - determines CC->CV switch behavior when charge is near complete
+  chargeModeLocal.internal_var.cc_mode.cv_mode_switch_hysteresis = gParams.charge_mode.cv_mode_switch_hysteresis; // determines CC->CV switch behavior when charge is near complete
+  // deeply discharged batteries sit below the short circuit voltage, pre-charge handles them
+  chargeModeLocal.internal_var.cc_mode.hiccup_off_10ms = 0;
   chargeModeLocal.internal_var.cc_mode.internal_var.previous_current = MAX_OUTPUT_CURRENT;
   chargeModeLocal.internal_var.cc_mode.state = CC_MODE_STATE_SOFT_START;
+  RAMP_Init(&chargeModeLocal.internal_var.cc_mode.internal_var.current_ramp, chargeModeLocal.internal_var.cc_mode.current, gParams.cc_mode.slew_rate, SYSTEM_10millis());
 
   // Setup CC-CV mode
-  chargeModeLocal.internal_var.cc_mode.internal_var.cv_mode.voltage = CHARGE_MODE_MaximumVoltageToMv(gSettings.charge_mode.voltage);
-  chargeModeLocal.internal_var.cc_mode.internal_var.cv_mode.max_voltage_ripple = TO_MILI(4.0);
+  chargeModeLocal.internal_var.cc_mode.internal_var.cv_mode.max_voltage_ripple = gParams.charge_mode.cv_max_voltage_ripple;
   // disable CV snubbing (required for charging)
   chargeModeLocal.internal_var.cc_mode.internal_var.cv_mode.snub_power = 0;
-  chargeModeLocal.internal_var.cc_mode.internal_var.cv_mode.soft_start_period_10ms = 5; // 5 -> 5*10ms=50ms
+  // battery leads are covered by the IR compensation
+  chargeModeLocal.internal_var.cc_mode.internal_var.cv_mode.cable_resistance = 0;
+  chargeModeLocal.internal_var.cc_mode.internal_var.cv_mode.hiccup_off_10ms = 0;
+  chargeModeLocal.internal_var.cc_mode.internal_var.cv_mode.soft_start_period_10ms = gParams.cv_mode.soft_start_period_10ms;
   chargeModeLocal.internal_var.cc_mode.internal_var.cv_mode.state = CV_MODE_STATE_ON;
+  RAMP_Init(&chargeModeLocal.internal_var.cc_mode.internal_var.cv_mode.internal_var.voltage_ramp, chargeModeLocal.internal_var.cc_mode.internal_var.cv_mode.voltage, gParams.cv_mode.slew_rate, SYSTEM_10millis());
 
   // clear leds
   LED_Clear();
@@ -94,13 +97,10 @@ void CHARGE_MODE_Init()
 /// @param chargeMode pointer to options struct
 void CHARGE_MODE_Regulate(ChargeMode_t *chargeMode)
 {
-  // Get current time
-  chargeMode->internal_var.current_time_10ms = SYSTEM_10millis();
-
-  // if not enough time passed since last regulation
-  if (chargeMode->internal_var.current_time_10ms - chargeMode->internal_var.last_regulation_10ms < chargeMode->regulation_period_10ms)
+  // converter stays paused while the battery voltage settles in the measurement window
+  if (chargeMode->internal_var.window_open)
   {
-    // exit early
+    PWM_Pause();
     return;
   }
 
@@ -112,49 +112,110 @@ void CHARGE_MODE_Regulate(ChargeMode_t *chargeMode)
 
   if (chargeMode->state == CHARGE_MODE_IDLE)
   {
+    // converter was just stopped (i.e. the profile changed while charging), the voltages are still settling
+    if (chargeMode->internal_var.window_10ms < CHARGE_MODE_WINDOW_SETTLE_10MS)
+    {
+      return;
+    }
+    // converter is not running yet, terminal voltage is the open circuit voltage of the battery, input voltage of the source
+    chargeMode->internal_var.open_circuit_voltage = gApp.output_voltage;
+    MPPT_Init(&chargeMode->internal_var.mppt, gApp.input_voltage);
     // check if battery voltage is higher than safe threshold
     if (gApp.output_voltage >= CHARGE_MODE_MinimumVoltageToMv(gSettings.charge_mode.voltage))
     {
       start_charging(chargeMode);
+      enter_stage(chargeMode, 0);
+    }
+    else if (gApp.output_voltage >= CHARGE_PROFILE_PrechargeVoltage(gSettings.charge_mode.voltage))
+    {
+      // battery is deeply discharged, try to recover it at reduced current first
+      start_precharge(chargeMode);
     }
     else
     {
-      // indicate that battery is deeply discharged and charging cannot be started for safety
+      // indicate that no battery, or a battery not matching the profile (chemistry, cell count) is connected
       gLed.error = 1;
       gLed.needs_update = 1;
       return;
     }
   }
 
-  // if battery is charged switch to standby mode (battery will still get trickle charged)
-  // output current must be <= 10% of programmed current, and output voltage must be reached
-  if ((chargeMode->state == CHARGE_MODE_CHARGING) && (gApp.output_current <= (chargeMode->internal_var.cc_mode.current / 20)) && (gApp.output_voltage >= chargeMode->internal_var.cc_mode.internal_var.cv_mode.voltage))
+  if (chargeMode->state == CHARGE_MODE_PRECHARGE)
   {
-    standby(chargeMode);
+    precharge(chargeMode);
+    if (chargeMode->state == CHARGE_MODE_PRECHARGE)
+    {
+      regulate(chargeMode);
+    }
+    return;
   }
 
-  CC_MODE_Regulate(&chargeMode->internal_var.cc_mode);
+  // walk the charge profile stages
+  run_stage(chargeMode);
+  if (chargeMode->state == CHARGE_MODE_FINISHED)
+  {
+    return;
+  }
+
+  regulate(chargeMode);
 }
 
 void CHARGE_MODE_Tick()
 {
   CHARGE_MODE_Regulate(&chargeModeLocal);
 }
+/// @brief Get CHARGE mode state machine state
+/// @return current state
+ChargeModeState_t CHARGE_MODE_GetState()
+{
+  return chargeModeLocal.state;
+}
+
+/// @brief Get battery voltage sampled with the converter paused, free of the I*R drop of the charging current
+/// @return open circuit voltage in mV (0 if not charging)
+uint16_t CHARGE_MODE_OpenCircuitVoltage()
+{
+  return chargeModeLocal.internal_var.open_circuit_voltage;
+}
+
+/// @brief Get series resistance of the battery and leads estimated from the measurement windows
+/// @return resistance in mOhm (0 if unknown)
+uint16_t CHARGE_MODE_Resistance()
+{
+  return chargeModeLocal.internal_var.resistance;
+}
+
 void CHARGE_MODE_TimeSlice10ms()
 {
+  measure_10ms(&chargeModeLocal);
 }
 void CHARGE_MODE_TimeSlice100ms()
 {
+  // paused converter draws no input power, the sample would mislead the tracker (it is seeded once charging starts)
+  if (gParams.charge_mode.solar && gSettings.output && chargeModeLocal.state != CHARGE_MODE_IDLE && !chargeModeLocal.internal_var.window_open)
+  {
+    MPPT_TimeSlice100ms(&chargeModeLocal.internal_var.mppt);
+  }
 }
 void CHARGE_MODE_TimeSlice500ms()
 {
-  toggle_config_leds();
-
-  if (chargeModeLocal.state == CHARGE_MODE_CHARGING)
+  if (chargeModeLocal.state == CHARGE_MODE_CHARGING || chargeModeLocal.state == CHARGE_MODE_PRECHARGE)
+  {
+    // show state of charge instead of config while charging
+    show_state_of_charge();
     toggle_output_status_led();
+  }
+  else
+  {
+    toggle_config_leds();
+  }
 }
 void CHARGE_MODE_TimeSlice1000ms()
 {
+  if (chargeModeLocal.state == CHARGE_MODE_CHARGING || chargeModeLocal.state == CHARGE_MODE_STANDBY || chargeModeLocal.state == CHARGE_MODE_PRECHARGE)
+  {
+    chargeModeLocal.internal_var.stage_time_1000ms++;
+  }
   if (chargeModeLocal.state == CHARGE_MODE_STANDBY)
     toggle_output_status_led();
 }
@@ -183,8 +244,16 @@ void CHARGE_MODE_OutputBtnPressed()
   {
     gSettings.charge_mode.current = CC_MODE_CURRENT_2MA;
   }
-  // Re-initialize with new params
-  CHARGE_MODE_Init();
+  if (gSettings.output && (chargeModeLocal.state == CHARGE_MODE_CHARGING || chargeModeLocal.state == CHARGE_MODE_STANDBY || chargeModeLocal.state == CHARGE_MODE_PRECHARGE))
+  {
+    // ramp the charging current to the new setting without interrupting the charge
+    apply_stage(&chargeModeLocal);
+  }
+  else
+  {
+    // Re-initialize with new params
+    CHARGE_MODE_Init();
+  }
   // Schedule settings save to EEPROM
   gSettingsSaveIn1000ms = SETTINGS_SAVE_DELAY_SECONDS;
 
@@ -194,14 +263,13 @@ void CHARGE_MODE_OutputBtnPressed()
 }
 void CHARGE_MODE_OutputBtnHeld()
 {
-  if (gSettings.charge_mode.voltage < CV_MODE_VOLTAGE_18V)
-  {
-    gSettings.charge_mode.voltage = (CvModeVoltage_t)(gSettings.charge_mode.voltage + 1);
-  }
-  else
+  // battery profile is selected one long press at a time, auto-repeat would cycle through chemistries
+  if (BUTTON_Repeating())
   {
-    gSettings.charge_mode.voltage = CV_MODE_VOLTAGE_1_5V;
+    return;
   }
+  // skip voltages that would exceed the diode reverse voltage budget at current input voltage
+  gSettings.charge_mode.voltage = SETPOINT_NextVoltageSetting(gSettings.charge_mode.voltage, true, true, CHARGE_MODE_MaximumVoltageToMv);
   // Re-initialize with new params
   CHARGE_MODE_Init();
   // Schedule settings save to EEPROM
@@ -293,24 +361,306 @@ static void toggle_output_status_led()
   }
 }
 
+// Render voltage based state of charge estimate on the bar graph
+static void show_state_of_charge()
+{
+  uint32_t minimum = CHARGE_MODE_MinimumVoltageToMv(gSettings.charge_mode.voltage);
+  uint32_t maximum = CHARGE_MODE_MaximumVoltageToMv(gSettings.charge_mode.voltage);
+  uint32_t level = 0;
+
+  uint32_t voltage = chargeModeLocal.internal_var.open_circuit_voltage;
+
+  if (voltage > minimum)
+  {
+    level = ((voltage - minimum) * LED_BAR_MAX) / (maximum - minimum);
+  }
+  LED_SetBar((level < LED_BAR_MAX) ? level : LED_BAR_MAX);
+}
+
 // state machine start CC charging action
 static void start_charging(ChargeMode_t *chargeMode)
 {
   chargeMode->state = CHARGE_MODE_CHARGING;
+  // config LEDs make room for state of charge bar graph
+  gLed.cv = 0;
+  LED_ClearBar();
 #ifdef EXTRA_DEBUG_MODE
   Serial.println(F("charge mode: starting"));
 #endif
 }
 
+// state machine start pre-charge action
+static void start_precharge(ChargeMode_t *chargeMode)
+{
+  start_charging(chargeMode);
+  chargeMode->state = CHARGE_MODE_PRECHARGE;
+  chargeMode->internal_var.stage_time_1000ms = 0;
+  chargeMode->internal_var.precharge_voltage = chargeMode->internal_var.open_circuit_voltage;
+  chargeMode->internal_var.precharge_check_1000ms = 0;
+  apply_stage(chargeMode);
+#ifdef DEBUG_MODE
+  Serial.println(F("charge mode: pre-charge"));
+#endif
+}
+
+// Escalate to the profile once the battery recovered to its minimum voltage, fault if it does not recover
+static void precharge(ChargeMode_t *chargeMode)
+{
+  ChargeModeInternalVar_t *var = &chargeMode->internal_var;
+  uint16_t minimum = CHARGE_MODE_MinimumVoltageToMv(gSettings.charge_mode.voltage);
+
+  // voltage limit holds the battery at the minimum, open circuit voltage settles just below it
+  if (var->open_circuit_voltage + CHARGE_PROFILE_TAPER_VOLTAGE_MARGIN >= minimum)
+  {
+    start_charging(chargeMode);
+    enter_stage(chargeMode, 0);
+    return;
+  }
+
+  // voltage has to keep rising, otherwise the cell is shorted or dead
+  if (var->stage_time_1000ms - var->precharge_check_1000ms >= (uint32_t)CHARGE_MODE_PRECHARGE_RISE_CHECK_MIN * 60)
+  {
+    if (var->open_circuit_voltage < var->precharge_voltage + minimum / CHARGE_MODE_PRECHARGE_RISE_DIV)
+    {
+      finish_charging(chargeMode);
+      APP_Fault(FAULT_CAUSE_PRECHARGE);
+      return;
+    }
+    var->precharge_voltage = var->open_circuit_voltage;
+    var->precharge_check_1000ms = var->stage_time_1000ms;
+  }
+
+  if (var->stage_time_1000ms >= (uint32_t)gParams.charge_mode.precharge_min * 60)
+  {
+    finish_charging(chargeMode);
+    APP_Fault(FAULT_CAUSE_PRECHARGE);
+  }
+}
+
 // state machine standby action
 static void standby(ChargeMode_t *chargeMode)
 {
   chargeMode->state = CHARGE_MODE_STANDBY;
+  // bring back config LEDs
+  LED_Clear();
+  init_leds();
 #ifdef EXTRA_DEBUG_MODE
   Serial.println(F("charge mode: standby"));
 #endif
 }
 
+// Load profile stage and apply its limits
+static void load_stage(ChargeMode_t *chargeMode, uint8_t index)
+{
+  chargeMode->internal_var.stage_index = index;
+  chargeMode->internal_var.stage_time_1000ms = 0;
+  chargeMode->internal_var.window_open = false;
+  chargeMode->internal_var.window_10ms = 0;
+  chargeMode->internal_var.ir_compensation = 0;
+  chargeMode->internal_var.loaded_sampled = false;
+  PEAK_DETECT_Init(&chargeMode->internal_var.peak, CHARGE_MODE_NDV_FILTER_SHIFT);
+  CHARGE_PROFILE_ReadStage(gSettings.charge_mode.voltage, index, &chargeMode->internal_var.stage);
+  apply_stage(chargeMode);
+}
+
+// Apply current and voltage limits of the active stage, regulation ramps to them
+static void apply_stage(ChargeMode_t *chargeMode)
+{
+  uint32_t current = (CC_MODE_CurrentSettingToMa(gSettings.charge_mode.current) * chargeMode->internal_var.stage.current) / 100;
+  uint32_t voltage = chargeMode->internal_var.stage.voltage + chargeMode->internal_var.ir_compensation;
+
+  // deeply discharged battery takes only a fraction of the stage current and is not charged past the profile minimum
+  if (chargeMode->state == CHARGE_MODE_PRECHARGE)
+  {
+    current = (current * gParams.charge_mode.precharge_current) / 100;
+    voltage = CHARGE_MODE_MinimumVoltageToMv(gSettings.charge_mode.voltage);
+  }
+  chargeMode->internal_var.cc_mode.current = current;
+  chargeMode->internal_var.cc_mode.internal_var.cv_mode.voltage = voltage;
+}
+
+// Enter profile stage, hold stage without timeout means float (standby), past the last stage charging is finished
+static void enter_stage(ChargeMode_t *chargeMode, uint8_t index)
+{
+  if (index >= CHARGE_PROFILE_StageCount(gSettings.charge_mode.voltage))
+  {
+    finish_charging(chargeMode);
+    return;
+  }
+  load_stage(chargeMode, index);
+  if (chargeMode->internal_var.stage.exit == CHARGE_EXIT_NONE && chargeMode->internal_var.stage.timeout_min == 0)
+  {
+    standby(chargeMode);
+  }
+#ifdef DEBUG_MODE
+  Serial.print(F("charge mode: stage "));
+  Serial.println(index);
+#endif
+}
+
+// Move on to the next stage once the exit rule of the active stage is met or the stage timed out,
+// voltage rules use the open circuit voltage so the I*R drop of the charging current does not end the stage early
+static void run_stage(ChargeMode_t *chargeMode)
+{
+  ChargeStage_t *stage = &chargeMode->internal_var.stage;
+  uint16_t voltage = chargeMode->internal_var.open_circuit_voltage;
+  bool done = false;
+
+  if (chargeMode->state != CHARGE_MODE_CHARGING && chargeMode->state != CHARGE_MODE_STANDBY)
+  {
+    return;
+  }
+
+  switch (stage->exit)
+  {
+  case CHARGE_EXIT_VOLTAGE:
+    done = voltage + CHARGE_PROFILE_TAPER_VOLTAGE_MARGIN >= stage->voltage;
+    break;
+  case CHARGE_EXIT_TAPER:
+    // live current reads 0 right after the window while the converter restarts, use the current sampled before it
+    done = chargeMode->internal_var.loaded_sampled &&
+           (voltage + CHARGE_PROFILE_TAPER_VOLTAGE_MARGIN >= stage->voltage) &&
+           (chargeMode->internal_var.loaded_current <= (CC_MODE_CurrentSettingToMa(gSettings.charge_mode.current) * stage->exit_param) / 100);
+    break;
+  case CHARGE_EXIT_NEG_DELTA_V:
+    done = neg_delta_v(chargeMode);
+    break;
+  default:
+    break;
+  }
+
+  if (stage->timeout_min > 0 && chargeMode->internal_var.stage_time_1000ms >= (uint32_t)stage->timeout_min * 60)
+  {
+    done = true;
+  }
+
+  if (done)
+  {
+    enter_stage(chargeMode, chargeMode->internal_var.stage_index + 1);
+  }
+}
+
+// Check if battery voltage peak passed (-dV) or the voltage stopped rising for too long (plateau)
+static bool neg_delta_v(ChargeMode_t *chargeMode)
+{
+  PeakDetect_t *peak = &chargeMode->internal_var.peak;
+  uint32_t plateau_samples = ((uint32_t)gParams.charge_mode.plateau_min * 60 * 100) / CHARGE_MODE_WINDOW_PERIOD_10MS;
+
+  if (chargeMode->internal_var.stage_time_1000ms < (uint32_t)CHARGE_MODE_NDV_HOLDOFF_MIN * 60)
+  {
+    return false;
+  }
+  if (PEAK_DETECT_Drop(peak) >= gParams.charge_mode.neg_delta_v)
+  {
+#ifdef DEBUG_MODE
+    Serial.print(F("charge mode: -dV, peak "));
+    Serial.println(peak->peak);
+#endif
+    return true;
+  }
+  return (plateau_samples > 0) && (peak->since_peak >= plateau_samples);
+}
+
+// Measurement window - periodically pause the converter and sample the open circuit battery voltage once it settled
+static void measure_10ms(ChargeMode_t *chargeMode)
+{
+  ChargeModeInternalVar_t *var = &chargeMode->internal_var;
+
+  // converter is off before charging starts, let the voltages settle as in the measurement window
+  if (chargeMode->state == CHARGE_MODE_IDLE)
+  {
+    var->window_open = false;
+    if (var->window_10ms < CHARGE_MODE_WINDOW_SETTLE_10MS)
+    {
+      var->window_10ms++;
+    }
+    return;
+  }
+
+  // float stage has no voltage decisions to take
+  if (!gSettings.output || (chargeMode->state != CHARGE_MODE_CHARGING && chargeMode->state != CHARGE_MODE_PRECHARGE))
+  {
+    var->window_open = false;
+    return;
+  }
+
+  var->window_10ms++;
+  if (!var->window_open)
+  {
+    if (var->window_10ms >= CHARGE_MODE_WINDOW_PERIOD_10MS)
+    {
+      // remember the operating point under current for the series resistance estimate
+      var->loaded_voltage = gApp.output_voltage;
+      var->loaded_current = gApp.output_current;
+      var->loaded_sampled = true;
+      var->window_open = true;
+      var->window_10ms = 0;
+    }
+    return;
+  }
+
+  if (var->window_10ms >= CHARGE_MODE_WINDOW_SETTLE_10MS)
+  {
+    var->open_circuit_voltage = gApp.output_voltage;
+    if (var->stage.exit == CHARGE_EXIT_NEG_DELTA_V)
+    {
+      PEAK_DETECT_Update(&var->peak, var->open_circuit_voltage);
+    }
+    compensate_ir(chargeMode);
+    var->window_open = false;
+    var->window_10ms = 0;
+  }
+}
+
+// Estimate series resistance from the voltage step between the loaded and open circuit voltage (dV/dI),
+// then raise the stage voltage limit by the configured share of the I*R drop so the CV phase does not start early
+static void compensate_ir(ChargeMode_t *chargeMode)
+{
+  ChargeModeInternalVar_t *var = &chargeMode->internal_var;
+  uint32_t compensation = 0;
+  uint32_t limit = var->stage.voltage / CHARGE_MODE_IR_MAX_COMPENSATION_DIV;
+
+  if (var->loaded_current >= CHARGE_MODE_IR_MIN_CURRENT && var->loaded_voltage > var->open_circuit_voltage)
+  {
+    uint32_t resistance = ((uint32_t)(var->loaded_voltage - var->open_circuit_voltage) * 1000) / var->loaded_current;
+    if (resistance > CHARGE_MODE_IR_MAX_RESISTANCE)
+    {
+      resistance = CHARGE_MODE_IR_MAX_RESISTANCE;
+    }
+    if (var->resistance == 0)
+    {
+      var->resistance = resistance;
+    }
+    else
+    {
+      var->resistance += ((int32_t)resistance - (int32_t)var->resistance) >> CHARGE_MODE_IR_FILTER_SHIFT;
+    }
+  }
+
+  // the battery itself must never be pushed over the stage voltage
+  if (var->open_circuit_voltage < var->stage.voltage)
+  {
+    compensation = ((uint32_t)var->loaded_current * var->resistance * gParams.charge_mode.ir_compensation) / (1000UL * 100);
+  }
+  var->ir_compensation = (compensation < limit) ? compensation : limit;
+  apply_stage(chargeMode);
+}
+
+// Run the battery current and voltage loops, with solar charging the input voltage loop may hold the duty cycle lower:
+// every loop moves the duty cycle by at most one step per tick, the lowest demand wins
+static void regulate(ChargeMode_t *chargeMode)
+{
+  uint8_t duty_cycle = gApp.duty_cycle;
+
+  CC_MODE_Regulate(&chargeMode->internal_var.cc_mode);
+
+  // source loaded past its maximum power point - back off regardless of the battery demand
+  if (gParams.charge_mode.solar && MPPT_Limit(&chargeMode->internal_var.mppt) && duty_cycle > MIN_DUTY_CYCLE && gApp.duty_cycle >= duty_cycle)
+  {
+    gApp.duty_cycle = duty_cycle - 1;
+  }
+}
+
 // state machine finish charging action
 static void finish_charging(ChargeMode_t *chargeMode)
 {
@@ -327,13 +677,13 @@ static void finish_charging(ChargeMode_t *chargeMode)
 /// @return voltage in mV
 uint16_t CHARGE_MODE_MinimumVoltageToMv(CvModeVoltage_t voltage)
 {
-  return minimumVoltage[voltage];
+  return CHARGE_PROFILE_MinimumVoltage(voltage);
 }
 
 /// @brief Get maximum voltage (fully charged) in mV from CvModeVoltage_t
 /// @param voltage CV mode voltage type
 /// @return voltage in mV
-uint16_t CHARGE_MODE_MaximumVoltageToMv(CvModeVoltage_t voltage)
+uint32_t CHARGE_MODE_MaximumVoltageToMv(CvModeVoltage_t voltage)
 {
-  return maximumVoltage[voltage];
+  return CHARGE_PROFILE_MaximumVoltage(voltage);
 }
@@ -20,14 +20,39 @@
 #include "settings.h"
 #include "cv_mode.h"
 #include "cc_mode.h"
+#include "charge_profile.h"
+#include "lib/peak_detect.h"
+#include "mppt.h"
+
+// Measurement window - period in 10ms between open circuit battery voltage samples taken with the converter paused
+#define CHARGE_MODE_WINDOW_PERIOD_10MS 100
+// Measurement window - time in 10ms the converter stays paused before the battery voltage is sampled
+#define CHARGE_MODE_WINDOW_SETTLE_10MS 4
+// -dV detection - filter strength of the battery voltage samples (1/2^x)
+#define CHARGE_MODE_NDV_FILTER_SHIFT 3
+// -dV detection - minutes at the start of the stage when -dV is ignored (deeply discharged cells show false peaks)
+#define CHARGE_MODE_NDV_HOLDOFF_MIN 5
+// IR compensation - min charging current in mA for a valid series resistance estimate
+#define CHARGE_MODE_IR_MIN_CURRENT 50
+// IR compensation - max plausible series resistance in mOhm, estimates above are clamped
+#define CHARGE_MODE_IR_MAX_RESISTANCE 1000
+// IR compensation - filter strength of the series resistance estimate (1/2^x)
+#define CHARGE_MODE_IR_FILTER_SHIFT 2
+// IR compensation - max voltage limit raise (1/x of the stage voltage)
+#define CHARGE_MODE_IR_MAX_COMPENSATION_DIV 20
+// Pre-charge - period in minutes of the battery voltage rise check
+#define CHARGE_MODE_PRECHARGE_RISE_CHECK_MIN 10
+// Pre-charge - min battery voltage rise per check period (1/x of the profile minimum voltage)
+#define CHARGE_MODE_PRECHARGE_RISE_DIV 100
 
 // charge mode state machine
 enum ChargeModeState_t : uint8_t
 {
-    CHARGE_MODE_IDLE = 0,
-    CHARGE_MODE_CHARGING,
-    CHARGE_MODE_STANDBY,
-    CHARGE_MODE_FINISHED
+    CHARGE_MODE_IDLE = 0, // waiting for the battery to be connected
+    CHARGE_MODE_CHARGING, // running a charge profile stage
+    CHARGE_MODE_STANDBY,  // running a hold stage (float)
+    CHARGE_MODE_FINISHED, // last profile stage done, output off
+    CHARGE_MODE_PRECHARGE // recovering deeply discharged battery at reduced current
 };
 typedef enum ChargeModeState_t ChargeModeState_t;
 
@@ -35,20 +60,35 @@ typedef enum ChargeModeState_t ChargeModeState_t;
 typedef struct
 {
     CcMode_t cc_mode;
-    unsigned long current_time_10ms;    // stores milis10ms() for current time
-    unsigned long last_regulation_10ms; // stores milis10ms() at the time last regulation took place
+    ChargeStage_t stage;                // active charge profile stage
+    uint8_t stage_index;                // index of the active stage within the profile
+    uint32_t stage_time_1000ms;         // time spent in the active stage in seconds
+    bool window_open;                   // measurement window is open, converter is paused
+    uint8_t window_10ms;                // time since the last window, or since the window opened while open (or since init while idle)
+    PeakDetect_t peak;                  // battery voltage peak detector for -dV termination
+    uint16_t open_circuit_voltage;      // battery voltage in mV sampled in the last measurement window
+    uint16_t loaded_voltage;            // output voltage in mV right before the last measurement window
+    uint16_t loaded_current;            // output current in mA right before the last measurement window
+    bool loaded_sampled;                // loaded operating point was sampled during the active stage
+    uint16_t resistance;                // estimated series resistance of the battery and leads in mOhm (0 - unknown)
+    uint16_t ir_compensation;           // voltage in mV added to the stage voltage limit for the I*R drop
+    uint16_t precharge_voltage;         // battery voltage in mV at the last pre-charge rise check
+    uint32_t precharge_check_1000ms;    // stage time at the last pre-charge rise check
+    Mppt_t mppt;                        // input maximum power point tracker (solar charging)
 } ChargeModeInternalVar_t;
 
 // Main charge mode struct
 typedef struct
 {
     ChargeModeState_t state;
-    uint16_t regulation_period_10ms; // defines how often (in 10ms) should the regulation take place (0 for fastest regulation)
     ChargeModeInternalVar_t internal_var;
 } ChargeMode_t;
 
 void CHARGE_MODE_Init();
 void CHARGE_MODE_Tick();
+ChargeModeState_t CHARGE_MODE_GetState();
+uint16_t CHARGE_MODE_OpenCircuitVoltage();
+uint16_t CHARGE_MODE_Resistance();
 void CHARGE_MODE_TimeSlice10ms();
 void CHARGE_MODE_TimeSlice100ms();
 void CHARGE_MODE_TimeSlice500ms();
@@ -58,5 +98,5 @@ void CHARGE_MODE_ModeBtnHeld();
 void CHARGE_MODE_OutputBtnPressed();
 void CHARGE_MODE_OutputBtnHeld();
 uint16_t CHARGE_MODE_MinimumVoltageToMv(CvModeVoltage_t voltage);
-uint16_t CHARGE_MODE_MaximumVoltageToMv(CvModeVoltage_t voltage);
+uint32_t CHARGE_MODE_MaximumVoltageToMv(CvModeVoltage_t voltage);
 #endif
\ No newline at end of file
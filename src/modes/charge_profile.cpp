@@ -0,0 +1,92 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+
+#include <Arduino.h>
+
+#include "charge_profile.h"
+
+// Charge profiles indexed by the charge voltage setting
+// minimum voltage, pre-charge voltage (above the full voltage of every profile with fewer cells), stages
+// stage: voltage limit, current limit %, exit rule, exit rule parameter, timeout in minutes
+static const ChargeProfile_t chargeProfiles[] PROGMEM = {
+    // nimh / rechargeable alkaline - constant current until -dV or plateau, 1.65V is only a safety limit
+    {TO_MILI(1.1), TO_MILI(0.5), 1, {{TO_MILI(1.65), 100, CHARGE_EXIT_NEG_DELTA_V, 0, 600}}},
+    // 3V coin battery - bulk, absorb, float at the same voltage
+    {TO_MILI(2.0), TO_MILI(1.8), 3, {{TO_MILI(3.1), 100, CHARGE_EXIT_VOLTAGE, 0, 600}, {TO_MILI(3.1), 100, CHARGE_EXIT_TAPER, 5, 120}, {TO_MILI(3.1), 100, CHARGE_EXIT_NONE, 0, 0}}},
+    // LIPO cell - bulk, absorb, no float (lithium must not be held at full voltage)
+    {TO_MILI(3.0), TO_MILI(2.0), 2, {{TO_MILI(4.12), 100, CHARGE_EXIT_VOLTAGE, 0, 600}, {TO_MILI(4.12), 100, CHARGE_EXIT_TAPER, 5, 120}}},
+    // LiFePO4 cell - bulk, absorb, no float
+    {TO_MILI(2.5), TO_MILI(2.0), 2, {{TO_MILI(3.6), 100, CHARGE_EXIT_VOLTAGE, 0, 600}, {TO_MILI(3.6), 100, CHARGE_EXIT_TAPER, 5, 120}}},
+    // 2S LIPO 4,12V×2 - bulk, absorb, no float
+    {TO_MILI(6.0), TO_MILI(4.5), 2, {{TO_MILI(8.24), 100, CHARGE_EXIT_VOLTAGE, 0, 600}, {TO_MILI(8.24), 100, CHARGE_EXIT_TAPER, 5, 120}}},
+    // 12V lead-acid battery - bulk, absorb at 14.4V for max 4 hours, float at 13.65V
+    {TO_MILI(10.0), TO_MILI(9.0), 3, {{TO_MILI(14.4), 100, CHARGE_EXIT_VOLTAGE, 0, 600}, {TO_MILI(14.4), 100, CHARGE_EXIT_TAPER, 5, 240}, {TO_MILI(13.65), 100, CHARGE_EXIT_NONE, 0, 0}}},
+    // 18V power tool battery 4V*5 = 20V - bulk, absorb, no float
+    {TO_MILI(15.0), TO_MILI(14.5), 2, {{TO_MILI(20.0), 100, CHARGE_EXIT_VOLTAGE, 0, 600}, {TO_MILI(20.0), 100, CHARGE_EXIT_TAPER, 5, 120}}}};
+
+static_assert(sizeof(chargeProfiles) / sizeof(chargeProfiles[0]) == CV_MODE_VOLTAGE_MAX, "chargeProfiles must have a row for every charge voltage setting");
+
+/// @brief Get number of stages of the profile
+/// @param profile charge voltage setting selecting the profile
+/// @return stage count
+uint8_t CHARGE_PROFILE_StageCount(CvModeVoltage_t profile)
+{
+  return pgm_read_byte(&chargeProfiles[profile].stage_count);
+}
+
+/// @brief Copy stage of the profile from flash
+/// @param profile charge voltage setting selecting the profile
+/// @param index stage index
+/// @param stage destination
+void CHARGE_PROFILE_ReadStage(CvModeVoltage_t profile, uint8_t index, ChargeStage_t *stage)
+{
+  memcpy_P(stage, &chargeProfiles[profile].stages[index], sizeof(ChargeStage_t));
+}
+
+/// @brief Get minimum battery voltage required to start charging
+/// @param profile charge voltage setting selecting the profile
+/// @return voltage in mV
+uint16_t CHARGE_PROFILE_MinimumVoltage(CvModeVoltage_t profile)
+{
+  return pgm_read_word(&chargeProfiles[profile].minimum_voltage);
+}
+
+/// @brief Get minimum battery voltage to attempt pre-charge of a deeply discharged battery
+/// @param profile charge voltage setting selecting the profile
+/// @return voltage in mV
+uint16_t CHARGE_PROFILE_PrechargeVoltage(CvModeVoltage_t profile)
+{
+  return pgm_read_word(&chargeProfiles[profile].precharge_voltage);
+}
+
+/// @brief Get highest voltage limit of the profile stages (fully charged voltage)
+/// @param profile charge voltage setting selecting the profile
+/// @return voltage in mV
+uint32_t CHARGE_PROFILE_MaximumVoltage(CvModeVoltage_t profile)
+{
+  uint32_t maximum = 0;
+
+  for (uint8_t i = 0; i < CHARGE_PROFILE_StageCount(profile); i++)
+  {
+    uint16_t voltage = pgm_read_word(&chargeProfiles[profile].stages[i].voltage);
+    if (voltage > maximum)
+    {
+      maximum = voltage;
+    }
+  }
+  return maximum;
+}
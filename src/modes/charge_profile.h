@@ -0,0 +1,67 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+
+#ifndef CHARGE_PROFILE_H
+#define CHARGE_PROFILE_H
+
+#include <stdint.h>
+
+#include "settings.h"
+#include "lib/util.h"
+
+// Max number of stages in a charge profile
+#define CHARGE_PROFILE_MAX_STAGES 3
+// Margin in mV below stage voltage at which the taper current is evaluated
+#define CHARGE_PROFILE_TAPER_VOLTAGE_MARGIN TO_MILI(0.05)
+
+// Charge stage exit rule
+enum ChargeExitRule_t : uint8_t
+{
+    CHARGE_EXIT_NONE = 0,   // hold the stage until its timeout (no timeout - hold forever, i.e. float)
+    CHARGE_EXIT_VOLTAGE,    // battery voltage reached the stage voltage (end of bulk)
+    CHARGE_EXIT_TAPER,      // current tapered below exit_param % of the charge current at the stage voltage
+    CHARGE_EXIT_NEG_DELTA_V // battery voltage dropped below its peak (-dV) or stopped rising (plateau), i.e. NiMH
+};
+typedef enum ChargeExitRule_t ChargeExitRule_t;
+
+// Charge stage (stored in flash), charges at current limit up to the voltage limit until the exit rule is met
+typedef struct
+{
+    uint16_t voltage;      // voltage limit in mV
+    uint8_t current;       // current limit in % of the charge current setting
+    ChargeExitRule_t exit; // exit rule
+    uint8_t exit_param;    // exit rule parameter
+    uint16_t timeout_min;  // stage time limit in minutes, next stage follows when exceeded (0 - no limit)
+} ChargeStage_t;
+
+// Charge profile of a battery chemistry (stored in flash), stages run in order and charging finishes after the last one
+typedef struct
+{
+    uint16_t minimum_voltage;                        // minimum battery voltage in mV to start charging
+    uint16_t precharge_voltage;                      // minimum battery voltage in mV to attempt pre-charge, lower is refused (wrong battery),
+                                                     // must be above the full voltage of every profile with fewer cells (i.e. 2S > 4.2V),
+                                                     // so a full pack of lower cell count is never pre-charged toward this profile
+    uint8_t stage_count;                             // number of stages used
+    ChargeStage_t stages[CHARGE_PROFILE_MAX_STAGES]; // stages
+} ChargeProfile_t;
+
+uint8_t CHARGE_PROFILE_StageCount(CvModeVoltage_t profile);
+void CHARGE_PROFILE_ReadStage(CvModeVoltage_t profile, uint8_t index, ChargeStage_t *stage);
+uint16_t CHARGE_PROFILE_MinimumVoltage(CvModeVoltage_t profile);
+uint16_t CHARGE_PROFILE_PrechargeVoltage(CvModeVoltage_t profile);
+uint32_t CHARGE_PROFILE_MaximumVoltage(CvModeVoltage_t profile);
+#endif
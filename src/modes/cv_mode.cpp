@@ -20,7 +20,11 @@
 
 #include "cv_mode.h"
 #include "app.h"
+#include "drivers/button.h"
 #include "drivers/led.h"
+#include "params.h"
+#include "setpoint.h"
+#include "thermal.h"
 #include "settings.h"
 #include "system.h"
 
@@ -29,11 +33,17 @@ static void protect(CvMode_t *cvMode);
 static void soft_start(CvMode_t *cvMode);
 static void snub(CvMode_t *cvMode);
 static void turn_on(CvMode_t *cvMode);
+static void load_setting();
+static void apply_setting();
 static void init_leds();
 static void toggle_leds();
+static uint32_t cable_compensation(CvMode_t *cvMode);
+static bool hiccup(CvMode_t *cvMode, uint32_t target_voltage);
 
 // Local CV mode struct
 static CvMode_t cvModeLocal;
+// First load point of the cable resistance measurement (current is 0 if not recorded)
+static CvCablePoint_t cablePoint;
 
 // Map CV mode setting voltages in mV
 static const uint16_t voltageSettings[] = {
@@ -49,20 +59,15 @@ static const uint16_t voltageSettings[] = {
 void CV_MODE_Init()
 {
   gApp.duty_cycle = 0;
-  cvModeLocal.voltage = CV_MODE_VoltageSettingToMv(gSettings.cv_mode.voltage);
-  cvModeLocal.max_voltage_ripple = TO_MILI(2.20);
-  cvModeLocal.soft_start_step_up_voltage = TO_MILI(0.001);
-  cvModeLocal.soft_start_period_10ms = 5; // 5 -> 5*10ms=50ms
-  if (gSettings.cv_mode.voltage == CV_MODE_VOLTAGE_5V)
-  {
-    // No snubbing for 5V mode - messes up USB phone charging
-    cvModeLocal.snub_power = 0;
-  }
-  else
-  {
-    cvModeLocal.snub_power = 3;
-  }
+  load_setting();
+  cvModeLocal.max_voltage_ripple = gParams.cv_mode.max_voltage_ripple;
+  cvModeLocal.soft_start_step_up_voltage = gParams.cv_mode.soft_start_step_up_voltage;
+  cvModeLocal.soft_start_period_10ms = gParams.cv_mode.soft_start_period_10ms;
+  cvModeLocal.cable_resistance = gParams.cv_mode.cable_resistance;
+  cvModeLocal.hiccup_off_10ms = gParams.cv_mode.hiccup_off_10ms;
+  HICCUP_Init(&cvModeLocal.internal_var.hiccup, SYSTEM_10millis());
   cvModeLocal.internal_var.previous_voltage = MAX_OUTPUT_VOLTAGE;
+  RAMP_Init(&cvModeLocal.internal_var.voltage_ramp, cvModeLocal.voltage, gParams.cv_mode.slew_rate, SYSTEM_10millis());
   soft_start(&cvModeLocal);
 
   // clear leds
@@ -86,6 +91,22 @@ void CV_MODE_Regulate(CvMode_t *cvMode)
   // Get current time
   cvMode->internal_var.current_time_10ms = SYSTEM_10millis();
 
+  // move the active target toward the requested one at limited slew rate, so live setting changes don't overshoot
+  RAMP_SetTarget(&cvMode->internal_var.voltage_ramp, cvMode->voltage);
+  // raise the target by the cable drop so the load at the far end sees the set voltage,
+  // lower it if input voltage rose, so Vin+Vout stays within the diode reverse voltage budget
+  uint32_t target_voltage = SETPOINT_ClampVoltage(RAMP_Update(&cvMode->internal_var.voltage_ramp, cvMode->internal_var.current_time_10ms) + cable_compensation(cvMode));
+  // duty cycle ceiling follows the target
+  gApp.target_voltage = target_voltage;
+  // when power stage gets hot, limit output current by lowering the voltage
+  bool current_limited = (gApp.derating < 100) && (gApp.output_current > THERMAL_Derate(MAX_OUTPUT_CURRENT));
+
+  // dead short - output stays off for a while, then soft start retries, so the load recovers without a reboot
+  if (hiccup(cvMode, target_voltage))
+  {
+    return;
+  }
+
   // TODO: Likely can add MPPT like this:
   // if(gApp.input_voltage < 5000)
   // {
@@ -96,7 +117,7 @@ void CV_MODE_Regulate(CvMode_t *cvMode)
   if (cvMode->state == CV_MODE_STATE_SNUB)
   {
     // once the voltage drops to desired snub level
-    if (gApp.output_voltage < ((cvMode->voltage * (100 - cvMode->snub_power)) / 100))
+    if (gApp.output_voltage < ((target_voltage * (100 - cvMode->snub_power)) / 100))
     {
       // special case when snub power is set to 0, we skip the soft start
       // this might cause oscilations of the output voltage, however might be useful for voltage insensitive loads like motors etc
@@ -117,8 +138,16 @@ void CV_MODE_Regulate(CvMode_t *cvMode)
     }
   }
 
+  // at light load run in bursts, holding the duty cycle so continuous regulation resumes where it left off
+  if (cvMode->state == CV_MODE_STATE_ON && !current_limited &&
+      PWM_Burst(gApp.output_current, gApp.output_voltage, target_voltage, PWM_BURST_VOLTAGE_HYSTERESIS))
+  {
+    cvMode->internal_var.previous_voltage = gApp.output_voltage;
+    return;
+  }
+
   // if voltage is below target voltage and duty cycle can be increased
-  if ((gApp.output_voltage < cvMode->voltage) && (gApp.duty_cycle < MAX_DUTY_CYCLE))
+  if (!current_limited && (gApp.output_voltage < target_voltage) && (gApp.duty_cycle < gApp.duty_ceiling))
   {
     // if in soft start state
     if (cvMode->state == CV_MODE_STATE_SOFT_START)
@@ -139,8 +168,8 @@ void CV_MODE_Regulate(CvMode_t *cvMode)
       gApp.duty_cycle += 1;
     }
   }
-  // if output voltage is too high, and duty cycle can be lowered
-  else if ((gApp.output_voltage > cvMode->voltage) && (gApp.duty_cycle > MIN_DUTY_CYCLE))
+  // if output voltage or current is too high, and duty cycle can be lowered
+  else if ((current_limited || gApp.output_voltage > target_voltage) && (gApp.duty_cycle > MIN_DUTY_CYCLE))
   {
     gApp.duty_cycle -= 1;
     // Disable soft start and turn on
@@ -150,9 +179,9 @@ void CV_MODE_Regulate(CvMode_t *cvMode)
     }
   }
 
-  if ((gApp.output_voltage >= cvMode->voltage) || (gApp.duty_cycle == MAX_DUTY_CYCLE))
+  if ((gApp.output_voltage >= target_voltage) || (gApp.duty_cycle >= gApp.duty_ceiling))
   {
-    // turn off soft start once the desired voltage or max duty cycle is reached
+    // turn off soft start once the desired voltage or duty cycle ceiling is reached
     if (cvMode->state == CV_MODE_STATE_SOFT_START)
     {
       turn_on(cvMode);
@@ -166,6 +195,13 @@ void CV_MODE_Tick()
 {
   CV_MODE_Regulate(&cvModeLocal);
 }
+/// @brief Get CV mode state machine state
+/// @return current state
+CV_MODE_STATE_t CV_MODE_GetState()
+{
+  return cvModeLocal.state;
+}
+
 void CV_MODE_TimeSlice10ms()
 {
 }
@@ -200,16 +236,9 @@ void CV_MODE_ModeBtnHeld()
 }
 void CV_MODE_OutputBtnPressed()
 {
-  if (gSettings.cv_mode.voltage < CV_MODE_VOLTAGE_18V)
-  {
-    gSettings.cv_mode.voltage = (CvModeVoltage_t)(gSettings.cv_mode.voltage + 1);
-  }
-  else
-  {
-    gSettings.cv_mode.voltage = CV_MODE_VOLTAGE_1_5V;
-  }
-  // Re-initialize with new params
-  CV_MODE_Init();
+  // skip voltages that would exceed the diode reverse voltage budget at current input voltage
+  gSettings.cv_mode.voltage = SETPOINT_NextVoltageSetting(gSettings.cv_mode.voltage, true, true, CV_MODE_VoltageSettingToMv);
+  apply_setting();
   // Schedule settings save to EEPROM
   gSettingsSaveIn1000ms = SETTINGS_SAVE_DELAY_SECONDS;
 
@@ -219,16 +248,10 @@ void CV_MODE_OutputBtnPressed()
 }
 void CV_MODE_OutputBtnHeld()
 {
-  if (gSettings.cv_mode.voltage > CV_MODE_VOLTAGE_1_5V)
-  {
-    gSettings.cv_mode.voltage = (CvModeVoltage_t)(gSettings.cv_mode.voltage - 1);
-  }
-  else
-  {
-    gSettings.cv_mode.voltage = CV_MODE_VOLTAGE_18V;
-  }
-  // Re-initialize with new params
-  CV_MODE_Init();
+  // skip voltages that would exceed the diode reverse voltage budget at current input voltage
+  // auto-repeat stops at the lowest voltage instead of jumping to the highest
+  gSettings.cv_mode.voltage = SETPOINT_NextVoltageSetting(gSettings.cv_mode.voltage, false, !BUTTON_Repeating(), CV_MODE_VoltageSettingToMv);
+  apply_setting();
   // Schedule settings save to EEPROM
   gSettingsSaveIn1000ms = SETTINGS_SAVE_DELAY_SECONDS;
 #ifdef DEBUG_MODE
@@ -241,9 +264,11 @@ static void protect(CvMode_t *cvMode)
 {
   // if the output voltage spikes beyond acceptable ouput voltage ripple (i.e load disconnected abruptly)
   // go to fail mode
-  if (cvMode->state == CV_MODE_STATE_ON)
+  // output is expected to lag above the target while it ramps down
+  Ramp_t *ramp = &cvMode->internal_var.voltage_ramp;
+  if (cvMode->state == CV_MODE_STATE_ON && ramp->value <= ramp->target)
   {
-    if (gApp.output_voltage > cvMode->voltage + cvMode->max_voltage_ripple)
+    if (gApp.output_voltage > ramp->value + cvMode->max_voltage_ripple)
     {
 #ifdef DEBUG_MODE
       Serial.print("cv mode: output overvoltage protection triggered. voltage reached:  ");
@@ -257,6 +282,72 @@ static void protect(CvMode_t *cvMode)
   }
 }
 
+// Detect short circuit (output voltage collapsed with output current at its limit) and run the hiccup cycle
+static bool hiccup(CvMode_t *cvMode, uint32_t target_voltage)
+{
+  if (cvMode->hiccup_off_10ms == 0)
+  {
+    return false;
+  }
+
+  bool shorted = (gApp.output_voltage < target_voltage / CV_MODE_SHORT_VOLTAGE_DIV) &&
+                 (gApp.output_current >= (THERMAL_Derate(MAX_OUTPUT_CURRENT) * HICCUP_CURRENT_PCT) / 100);
+
+  switch (HICCUP_Update(&cvMode->internal_var.hiccup, shorted, HICCUP_DETECT_10MS, cvMode->hiccup_off_10ms, cvMode->internal_var.current_time_10ms))
+  {
+  case HICCUP_OFF:
+    gApp.duty_cycle = 0;
+    // turn on error LED - indicating that output is shorted
+    gLed.error = 1;
+    gLed.needs_update = 1;
+    return true;
+  case HICCUP_RETRY:
+    soft_start(cvMode);
+    return false;
+  default:
+    return false;
+  }
+}
+
+// Voltage in mV dropped on the output cable at the present output current
+static uint32_t cable_compensation(CvMode_t *cvMode)
+{
+  uint32_t compensation = (gApp.output_current * cvMode->cable_resistance) / 1000;
+  uint32_t limit = cvMode->max_voltage_ripple / CV_MODE_CABLE_COMPENSATION_RIPPLE_DIV;
+
+  return (compensation < limit) ? compensation : limit;
+}
+
+// Load voltage setting
+static void load_setting()
+{
+  cvModeLocal.voltage = CV_MODE_VoltageSettingToMv(gSettings.cv_mode.voltage);
+  if (gSettings.cv_mode.voltage == CV_MODE_VOLTAGE_5V)
+  {
+    // No snubbing for 5V mode - messes up USB phone charging
+    cvModeLocal.snub_power = 0;
+  }
+  else
+  {
+    cvModeLocal.snub_power = gParams.cv_mode.snub_power;
+  }
+}
+
+// Apply changed voltage setting - live output ramps to the new voltage, otherwise start over
+static void apply_setting()
+{
+  if (gSettings.output && cvModeLocal.state == CV_MODE_STATE_ON)
+  {
+    load_setting();
+    LED_Clear();
+    init_leds();
+  }
+  else
+  {
+    CV_MODE_Init();
+  }
+}
+
 // state machine soft start action
 static void soft_start(CvMode_t *cvMode)
 {
@@ -367,3 +458,34 @@ static void toggle_leds()
   // request updates
   gLed.needs_update = 1;
 }
+
+/// @brief Record load point for the cable resistance measurement, two points at different load currents are needed
+/// @param load_voltage voltage in mV measured at the load end of the cable
+/// @return cable resistance in mOhm once both points are recorded, -1 if another point is needed
+int32_t CV_MODE_MeasureCable(uint32_t load_voltage)
+{
+  CvCablePoint_t point;
+
+  point.current = gApp.output_current;
+  point.drop = (gApp.output_voltage > load_voltage) ? gApp.output_voltage - load_voltage : 0;
+  point.recorded = true;
+
+  // two points cancel the offset between the meter at the load and the output voltage reading
+  if (!cablePoint.recorded || point.current == cablePoint.current)
+  {
+    cablePoint = point;
+    return -1;
+  }
+
+  int32_t resistance = (((int32_t)point.drop - (int32_t)cablePoint.drop) * 1000) / ((int32_t)point.current - (int32_t)cablePoint.current);
+  CV_MODE_ClearCable();
+  return (resistance > 0) ? resistance : 0;
+}
+
+/// @brief Forget the recorded cable measurement load point
+void CV_MODE_ClearCable()
+{
+  cablePoint.current = 0;
+  cablePoint.drop = 0;
+  cablePoint.recorded = false;
+}
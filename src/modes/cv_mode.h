@@ -20,6 +20,14 @@
 #include <stdint.h>
 
 #include "settings.h"
+#include "lib/ramp.h"
+#include "lib/hiccup.h"
+
+// Cable drop compensation - max target raise (1/x of max_voltage_ripple), so releasing the load does not trip snubbing
+#define CV_MODE_CABLE_COMPENSATION_RIPPLE_DIV 2
+
+// Hiccup foldback - output voltage below 1/x of the target (with output current at its limit) is a short circuit
+#define CV_MODE_SHORT_VOLTAGE_DIV 4
 
 // CV mode state machine
 enum CV_MODE_STATE_t : uint8_t
@@ -36,22 +44,35 @@ typedef struct
     uint32_t previous_voltage;              // stores previous reading of the output voltage in mV
     unsigned long current_time_10ms;        // stores milis10ms() for current time
     unsigned long last_soft_regulated_10ms; // stores milis10ms() at the time last soft regulation took place
+    Ramp_t voltage_ramp;                    // active target voltage in mV, follows voltage at limited slew rate
+    Hiccup_t hiccup;                        // short circuit hiccup foldback
 } CvModeInternalVar_t;
 
 // Main CV mode struct
 typedef struct
 {
     CV_MODE_STATE_t state;               // cv mode current state
-    uint32_t voltage;                    // target output voltage in mV
+    uint32_t voltage;                    // requested target output voltage in mV
     uint32_t max_voltage_ripple;         // max output voltage ripple in mV, if breached soft start is enabled and duty dropped to 0
     uint32_t soft_start_step_up_voltage; // define step up in mV during soft start, higher the value the more agressive will be the soft start ramp up
     uint8_t soft_start_period_10ms;      // defines delay in 10ms between soft start regulations, higher delay = slower soft start
     uint8_t snub_power;                  // defines snubbing power which is a target voltage drop percentage (0-100%)
+    uint16_t cable_resistance;           // output cable resistance in mOhm, target is raised by its I*R drop (0 - off)
+    uint16_t hiccup_off_10ms;            // output off time in 10ms after a short circuit (0 - no hiccup foldback)
     CvModeInternalVar_t internal_var;    // internal variables
 } CvMode_t;
 
+// Load point recorded for the cable resistance measurement
+typedef struct
+{
+    uint32_t current; // output current in mA
+    uint32_t drop;    // output voltage minus the voltage at the load in mV
+    bool recorded;    // first point was recorded
+} CvCablePoint_t;
+
 void CV_MODE_Init();
 void CV_MODE_Tick();
+CV_MODE_STATE_t CV_MODE_GetState();
 void CV_MODE_Regulate(CvMode_t *cvMode);
 void CV_MODE_TimeSlice10ms();
 void CV_MODE_TimeSlice100ms();
@@ -62,4 +83,6 @@ void CV_MODE_ModeBtnHeld();
 void CV_MODE_OutputBtnPressed();
 void CV_MODE_OutputBtnHeld();
 uint32_t CV_MODE_VoltageSettingToMv(CvModeVoltage_t voltage);
+int32_t CV_MODE_MeasureCable(uint32_t load_voltage);
+void CV_MODE_ClearCable();
 #endif
\ No newline at end of file
@@ -18,11 +18,75 @@
 #include <Arduino.h>
 #endif
 
+#include "error_mode.h"
 #include "app.h"
 #include "drivers/led.h"
 #include "settings.h"
 #include "system.h"
 
+// Local functions
+static void recover();
+
+// Local error mode struct, latched unless entered through ERROR_MODE_Trip()
+static ErrorMode_t errorModeLocal = {FAULT_CAUSE_NONE, APP_MODE_IDLE, 0, true, 0, 0};
+
+// Recovery policy per fault cause
+static const ErrorRecoveryPolicy_t recoveryPolicy[FAULT_CAUSE_MAX] = {
+    // cooldown, max retries
+    {0, 0},   // FAULT_CAUSE_NONE - latch
+    {100, 5}, // FAULT_CAUSE_INPUT_OVERCURRENT - 1s, 2s, 4s, 8s, 16s
+    {100, 5}, // FAULT_CAUSE_OUTPUT_OVERCURRENT - 1s, 2s, 4s, 8s, 16s
+    {200, 3}, // FAULT_CAUSE_OUTPUT_OVERVOLTAGE - 2s, 4s, 8s
+    {0, 0},   // FAULT_CAUSE_NO_OUTPUT - physical fault, latch
+    {500, 5}, // FAULT_CAUSE_DIODE_REVERSE_VOLTAGE - wait for input voltage to drop, 5s, 10s, 20s, 40s, 80s
+    {6000, 3}, // FAULT_CAUSE_OVER_TEMPERATURE - let it cool down, 60s, 120s, 240s
+    {0, 0},   // FAULT_CAUSE_PRECHARGE - damaged battery, latch
+};
+
+/// @brief Enter error mode due to the fault and schedule recovery according to the fault cause policy
+/// @param cause fault cause
+void ERROR_MODE_Trip(FaultCause_t cause)
+{
+  unsigned long now = SYSTEM_10millis();
+  const ErrorRecoveryPolicy_t *policy = &recoveryPolicy[cause];
+
+  errorModeLocal.cause = cause;
+  errorModeLocal.previous_mode = gSettings.mode;
+
+  // device ran long enough since the last recovery - start counting retries again
+  if (now - errorModeLocal.last_recovery_10ms >= ERROR_MODE_STABLE_PERIOD_10MS)
+  {
+    errorModeLocal.retries = 0;
+  }
+
+  // latch if retries are exhausted, or fault happened in a mode that cannot be re-entered
+  errorModeLocal.latched = (errorModeLocal.retries >= policy->max_retries ||
+                            gSettings.mode == APP_MODE_ERROR ||
+                            gSettings.mode == APP_MODE_CALIBRATION);
+
+  if (!errorModeLocal.latched)
+  {
+    uint8_t shift = (errorModeLocal.retries < ERROR_MODE_MAX_BACKOFF_SHIFT) ? errorModeLocal.retries : ERROR_MODE_MAX_BACKOFF_SHIFT;
+    // exponential backoff
+    errorModeLocal.recover_at_10ms = now + ((unsigned long)policy->cooldown_10ms << shift);
+    errorModeLocal.retries++;
+  }
+#ifdef DEBUG_MODE
+  Serial.print(F("error mode: retry "));
+  Serial.print(errorModeLocal.retries);
+  Serial.println(errorModeLocal.latched ? F(" latched") : F(" scheduled"));
+#endif
+
+  ERROR_MODE_Init();
+}
+
+/// @brief Check if error mode is kept until reboot
+/// @return true if no recovery is scheduled
+bool ERROR_MODE_IsLatched()
+{
+  return errorModeLocal.latched;
+}
+
 void ERROR_MODE_Init()
 {
   // Keep duty cycle at 0
@@ -41,6 +105,11 @@ void ERROR_MODE_Tick()
 }
 void ERROR_MODE_TimeSlice10ms()
 {
+  // check if cooldown has passed
+  if (!errorModeLocal.latched && (long)(SYSTEM_10millis() - errorModeLocal.recover_at_10ms) >= 0)
+  {
+    recover();
+  }
 }
 void ERROR_MODE_TimeSlice100ms()
 {
@@ -82,4 +151,16 @@ void ERROR_MODE_OutputBtnHeld()
 #ifdef DEBUG_MODE
   Serial.println("error mode: output btn held");
 #endif
-}
\ No newline at end of file
+}
+
+// Re-enter the previous mode, it starts through the soft start
+static void recover()
+{
+#ifdef DEBUG_MODE
+  Serial.println(F("error mode: recovering"));
+#endif
+  errorModeLocal.latched = true;
+  errorModeLocal.last_recovery_10ms = SYSTEM_10millis();
+  gSettings.mode = errorModeLocal.previous_mode;
+  APP_InitCurrentApp();
+}
@@ -17,7 +17,37 @@
 #ifndef ERROR_MODE_H
 #define ERROR_MODE_H
 
+#include <stdint.h>
+
+#include "fault_log.h"
+#include "settings.h"
+
+// Time in 10ms the device has to run without a fault after recovery to reset the retry counter
+#define ERROR_MODE_STABLE_PERIOD_10MS 6000 // 6000*10ms = 60s
+// Max amount of cooldown doublings, limits the backoff growth
+#define ERROR_MODE_MAX_BACKOFF_SHIFT 6
+
+// Recovery policy of a fault cause
+typedef struct
+{
+    uint16_t cooldown_10ms; // cooldown before the first retry in 10ms, doubled on every next retry
+    uint8_t max_retries;    // amount of retries before latching (0 - latch on first fault)
+} ErrorRecoveryPolicy_t;
+
+// Main error mode struct
+typedef struct
+{
+    FaultCause_t cause;                 // fault that caused the error mode
+    AppMode_t previous_mode;            // mode to re-enter on recovery
+    uint8_t retries;                    // retries since the last stable period
+    bool latched;                       // if set, error mode is kept until reboot
+    unsigned long recover_at_10ms;      // stores milis10ms() when the recovery should take place
+    unsigned long last_recovery_10ms;   // stores milis10ms() of the last recovery
+} ErrorMode_t;
+
 void ERROR_MODE_Init();
+void ERROR_MODE_Trip(FaultCause_t cause);
+bool ERROR_MODE_IsLatched();
 void ERROR_MODE_Tick();
 void ERROR_MODE_TimeSlice10ms();
 void ERROR_MODE_TimeSlice100ms();
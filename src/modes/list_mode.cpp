@@ -0,0 +1,420 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+
+#include <Arduino.h>
+
+#include "list_mode.h"
+#include "cc_mode.h"
+#include "cv_mode.h"
+#include "app.h"
+#include "drivers/led.h"
+#include "params.h"
+#include "settings.h"
+#include "system.h"
+
+// List must fit its EEPROM region
+static_assert(sizeof(ListProgram_t) <= EEPROM_LIST_END_ADDRESS - EEPROM_LIST_ADDRESS, "list does not fit its EEPROM region");
+// List is read and written in a single EEPROM transfer
+static_assert(sizeof(ListProgram_t) <= UINT8_MAX, "list is too big for a single EEPROM transfer");
+
+// Local functions
+static void start_step(ListMode_t *listMode, uint8_t index);
+static void next_step(ListMode_t *listMode);
+static void finish(ListMode_t *listMode);
+static void report_step(ListMode_t *listMode);
+static bool regulates_voltage(ListStepType_t type);
+static uint16_t ramp_rate(uint32_t from, uint32_t to, uint32_t duration_10ms);
+static void init_leds();
+
+// Local list mode struct
+static ListMode_t listModeLocal;
+// List program
+static ListProgram_t program;
+
+// Step type names
+static const char typeOff[] PROGMEM = "off";
+static const char typeCv[] PROGMEM = "cv";
+static const char typeCc[] PROGMEM = "cc";
+static const char typeCvRamp[] PROGMEM = "cv_ramp";
+static const char typeCcRamp[] PROGMEM = "cc_ramp";
+static const char *const typeNames[] PROGMEM = {typeOff, typeCv, typeCc, typeCvRamp, typeCcRamp};
+static_assert(sizeof(typeNames) / sizeof(typeNames[0]) == LIST_STEP_MAX, "typeNames must have a name for every ListStepType_t");
+
+/// @brief Load list program from EEPROM
+void LIST_MODE_Setup()
+{
+  SETTINGS_Read(EEPROM_LIST_ADDRESS, &program, sizeof(program));
+  if (program.magic != LIST_MODE_MAGIC || program.count > LIST_MODE_MAX_STEPS)
+  {
+    memset(&program, 0, sizeof(program));
+    program.magic = LIST_MODE_MAGIC;
+  }
+}
+
+/// @brief Initialize list mode, the list starts over from the first step when the output is on
+void LIST_MODE_Init()
+{
+  gApp.duty_cycle = 0;
+  listModeLocal.state = LIST_MODE_IDLE;
+  listModeLocal.step_index = 0;
+  listModeLocal.pass = 0;
+
+  // Setup CC mode
+  listModeLocal.cc_mode.max_current_ripple = gParams.cc_mode.max_current_ripple;
+  listModeLocal.cc_mode.soft_start_step_up_current = gParams.cc_mode.soft_start_step_up_current;
+  listModeLocal.cc_mode.soft_start_period_10ms = gParams.cc_mode.soft_start_period_10ms;
+  listModeLocal.cc_mode.snub_power = gParams.cc_mode.snub_power;
+  listModeLocal.cc_mode.cv_mode_switch_hysteresis = gParams.cc_mode.cv_mode_switch_hysteresis;
+  listModeLocal.cc_mode.hiccup_off_10ms = gParams.cc_mode.hiccup_off_10ms;
+  HICCUP_Init(&listModeLocal.cc_mode.internal_var.hiccup, SYSTEM_10millis());
+
+  // Setup CV mode
+  listModeLocal.cc_mode.internal_var.cv_mode.max_voltage_ripple = gParams.cc_mode.cv_max_voltage_ripple;
+  listModeLocal.cc_mode.internal_var.cv_mode.snub_power = gParams.cv_mode.snub_power;
+  listModeLocal.cc_mode.internal_var.cv_mode.soft_start_period_10ms = gParams.cv_mode.soft_start_period_10ms;
+  listModeLocal.cc_mode.internal_var.cv_mode.hiccup_off_10ms = 0;
+
+  // clear leds
+  LED_Clear();
+  init_leds();
+
+  if (gSettings.output && program.count > 0)
+  {
+    listModeLocal.state = LIST_MODE_RUNNING;
+    start_step(&listModeLocal, 0);
+  }
+}
+
+/// @brief Regulate output according to the active step
+/// @param listMode pointer to options struct
+void LIST_MODE_Regulate(ListMode_t *listMode)
+{
+  // if output is turned off or list is not running exit early
+  if (!gSettings.output || listMode->state != LIST_MODE_RUNNING)
+  {
+    return;
+  }
+
+  if (listMode->step.type == LIST_STEP_OFF)
+  {
+    gApp.duty_cycle = 0;
+    return;
+  }
+
+  CC_MODE_Regulate(&listMode->cc_mode);
+}
+
+void LIST_MODE_Tick()
+{
+  LIST_MODE_Regulate(&listModeLocal);
+}
+
+/// @brief Get LIST mode state machine state
+/// @return current state
+ListModeState_t LIST_MODE_GetState()
+{
+  return listModeLocal.state;
+}
+
+/// @brief Get index of the active step
+/// @return step index
+uint8_t LIST_MODE_Step()
+{
+  return listModeLocal.step_index;
+}
+
+void LIST_MODE_TimeSlice10ms()
+{
+  if (!gSettings.output || listModeLocal.state != LIST_MODE_RUNNING)
+  {
+    return;
+  }
+  if (SYSTEM_10millis() - listModeLocal.step_start_10ms >= listModeLocal.step.duration_10ms)
+  {
+    next_step(&listModeLocal);
+  }
+}
+void LIST_MODE_TimeSlice100ms()
+{
+}
+void LIST_MODE_TimeSlice500ms()
+{
+  // show progress through the list on the bar graph
+  if (listModeLocal.state == LIST_MODE_RUNNING)
+  {
+    LED_SetBar(((uint32_t)(listModeLocal.step_index + 1) * LED_BAR_MAX) / program.count);
+  }
+}
+void LIST_MODE_TimeSlice1000ms()
+{
+  // blink the X8 led to indicate output on
+  if (gSettings.output)
+  {
+    gLed.x8 = !gLed.x8;
+    gLed.needs_update = 1;
+  }
+}
+
+void LIST_MODE_ModeBtnPressed()
+{
+  APP_OutputToggle();
+#ifdef DEBUG_MODE
+  Serial.println("list mode: mode btn pressed");
+#endif
+}
+void LIST_MODE_ModeBtnHeld()
+{
+  APP_NextMode();
+#ifdef DEBUG_MODE
+  Serial.println("list mode: mode btn held");
+#endif
+}
+void LIST_MODE_OutputBtnPressed()
+{
+}
+void LIST_MODE_OutputBtnHeld()
+{
+}
+
+/// @brief Append step to the list
+/// @param type step type
+/// @param setpoint regulated voltage in mV or current in mA
+/// @param limit current limit in mA (CV) or voltage limit in mV (CC), 0 for the hardware max
+/// @param duration_10ms step duration in 10ms
+/// @return true if step was accepted
+bool LIST_MODE_Add(ListStepType_t type, uint32_t setpoint, uint32_t limit, uint32_t duration_10ms)
+{
+  uint32_t max_setpoint = regulates_voltage(type) ? MAX_OUTPUT_VOLTAGE : MAX_OUTPUT_CURRENT;
+  uint32_t max_limit = regulates_voltage(type) ? MAX_OUTPUT_CURRENT : MAX_OUTPUT_VOLTAGE;
+
+  if (program.count >= LIST_MODE_MAX_STEPS || type >= LIST_STEP_MAX || duration_10ms == 0)
+  {
+    return false;
+  }
+  if (type != LIST_STEP_OFF && (setpoint > max_setpoint || limit > max_limit))
+  {
+    return false;
+  }
+  // off step doesn't use them, don't store values that were never range checked
+  if (type == LIST_STEP_OFF)
+  {
+    setpoint = 0;
+    limit = 0;
+  }
+
+  ListStep_t *step = &program.steps[program.count++];
+  step->type = type;
+  step->setpoint = setpoint;
+  step->limit = limit;
+  step->duration_10ms = duration_10ms;
+  return true;
+}
+
+/// @brief Set amount of passes through the list
+/// @param repeat passes (0 - repeat forever)
+void LIST_MODE_SetRepeat(uint8_t repeat)
+{
+  program.repeat = repeat;
+}
+
+/// @brief Remove all steps, a running list is stopped
+void LIST_MODE_Clear()
+{
+  program.count = 0;
+  program.repeat = 0;
+  if (gSettings.mode == APP_MODE_LIST)
+  {
+    APP_OutputOff();
+    APP_InitCurrentApp();
+  }
+}
+
+/// @brief Persist list program to EEPROM
+void LIST_MODE_Save()
+{
+  program.magic = LIST_MODE_MAGIC;
+  SETTINGS_Write(EEPROM_LIST_ADDRESS, &program, sizeof(program));
+}
+
+/// @brief Print list program, one "index type setpoint limit duration" line per step
+void LIST_MODE_Print()
+{
+  Serial.print(F("steps="));
+  Serial.print(program.count);
+  Serial.print(F(" repeat="));
+  Serial.println(program.repeat);
+
+  for (uint8_t i = 0; i < program.count; i++)
+  {
+    Serial.print(i);
+    Serial.print(' ');
+    Serial.print((const __FlashStringHelper *)pgm_read_ptr(&typeNames[program.steps[i].type]));
+    Serial.print(' ');
+    Serial.print(program.steps[i].setpoint);
+    Serial.print(' ');
+    Serial.print(program.steps[i].limit);
+    Serial.print(' ');
+    Serial.println(program.steps[i].duration_10ms * 10);
+  }
+}
+
+/// @brief Find step type by name
+/// @param name step type name
+/// @return step type or LIST_STEP_MAX if not found
+ListStepType_t LIST_MODE_FindType(const char *name)
+{
+  for (uint8_t i = 0; i < LIST_STEP_MAX; i++)
+  {
+    if (strcmp_P(name, (const char *)pgm_read_ptr(&typeNames[i])) == 0)
+    {
+      return (ListStepType_t)i;
+    }
+  }
+  return LIST_STEP_MAX;
+}
+
+// Start step, regulated quantity ramps from its present value when it changes, limits apply at once
+static void start_step(ListMode_t *listMode, uint8_t index)
+{
+  ListStepType_t previous = listMode->step.type;
+  bool continuous = (listMode->state == LIST_MODE_RUNNING) && (index > 0 || listMode->pass > 0) && (previous != LIST_STEP_OFF);
+  CcMode_t *ccMode = &listMode->cc_mode;
+  CvMode_t *cvMode = &ccMode->internal_var.cv_mode;
+  Ramp_t *voltage_ramp = &cvMode->internal_var.voltage_ramp;
+  Ramp_t *current_ramp = &ccMode->internal_var.current_ramp;
+  unsigned long now = SYSTEM_10millis();
+
+  listMode->step_index = index;
+  // steps are back to back, rounding of the slice does not accumulate
+  listMode->step_start_10ms = (index > 0 || listMode->pass > 0) ? listMode->step_start_10ms + listMode->step.duration_10ms : now;
+  memcpy(&listMode->step, &program.steps[index], sizeof(ListStep_t));
+  ListStep_t *step = &listMode->step;
+
+  if (step->type == LIST_STEP_OFF)
+  {
+    gApp.duty_cycle = 0;
+    report_step(listMode);
+    return;
+  }
+
+  // output was off - regulate from soft start
+  if (!continuous)
+  {
+    gApp.duty_cycle = 0;
+    ccMode->state = CC_MODE_STATE_SOFT_START;
+    ccMode->internal_var.previous_current = MAX_OUTPUT_CURRENT;
+    cvMode->state = CV_MODE_STATE_ON;
+    cvMode->internal_var.previous_voltage = MAX_OUTPUT_VOLTAGE;
+  }
+
+  if (regulates_voltage(step->type))
+  {
+    ccMode->current = (step->limit > 0) ? step->limit : MAX_OUTPUT_CURRENT;
+    cvMode->voltage = step->setpoint;
+    cvMode->cable_resistance = gParams.cv_mode.cable_resistance;
+    RAMP_Init(current_ramp, ccMode->current, 0, now);
+    if (!continuous || !regulates_voltage(previous))
+    {
+      RAMP_Init(voltage_ramp, gApp.output_voltage, 0, now);
+    }
+    voltage_ramp->rate = (step->type == LIST_STEP_CV_RAMP) ? ramp_rate(voltage_ramp->value, step->setpoint, step->duration_10ms) : gParams.cv_mode.slew_rate;
+  }
+  else
+  {
+    ccMode->current = step->setpoint;
+    cvMode->voltage = (step->limit > 0) ? step->limit : MAX_OUTPUT_VOLTAGE;
+    cvMode->cable_resistance = 0;
+    RAMP_Init(voltage_ramp, cvMode->voltage, 0, now);
+    if (!continuous || regulates_voltage(previous))
+    {
+      RAMP_Init(current_ramp, gApp.output_current, 0, now);
+    }
+    current_ramp->rate = (step->type == LIST_STEP_CC_RAMP) ? ramp_rate(current_ramp->value, step->setpoint, step->duration_10ms) : gParams.cc_mode.slew_rate;
+  }
+
+  gLed.cv = regulates_voltage(step->type);
+  gLed.cc = !gLed.cv;
+  gLed.needs_update = 1;
+  report_step(listMode);
+}
+
+// Advance to the next step, wrapping around for the next pass
+static void next_step(ListMode_t *listMode)
+{
+  if (listMode->step_index + 1 < program.count)
+  {
+    start_step(listMode, listMode->step_index + 1);
+    return;
+  }
+
+  listMode->pass++;
+  if (program.repeat > 0 && listMode->pass >= program.repeat)
+  {
+    finish(listMode);
+    return;
+  }
+  start_step(listMode, 0);
+}
+
+// state machine finish action
+static void finish(ListMode_t *listMode)
+{
+  listMode->state = LIST_MODE_FINISHED;
+  APP_OutputOff();
+  LED_ClearBar();
+  Serial.print(F("list: finished pass="));
+  Serial.println(listMode->pass);
+}
+
+// Report step boundary on the serial console
+static void report_step(ListMode_t *listMode)
+{
+  Serial.print(F("list: step="));
+  Serial.print(listMode->step_index);
+  Serial.print(F(" pass="));
+  Serial.print(listMode->pass);
+  Serial.print(F(" time="));
+  Serial.println(listMode->step_start_10ms);
+}
+
+// Check if step type regulates the output voltage (otherwise the output current)
+static bool regulates_voltage(ListStepType_t type)
+{
+  return type == LIST_STEP_CV || type == LIST_STEP_CV_RAMP;
+}
+
+// Ramp rate per 10ms covering the change within the duration, at least 1 (0 would jump)
+static uint16_t ramp_rate(uint32_t from, uint32_t to, uint32_t duration_10ms)
+{
+  uint32_t delta = (to > from) ? (to - from) : (from - to);
+  uint32_t rate = delta / duration_10ms;
+
+  if (rate == 0)
+  {
+    return 1;
+  }
+  return (rate < UINT16_MAX) ? rate : UINT16_MAX;
+}
+
+// Initialize LED to show status
+static void init_leds()
+{
+  gLed.cv = 1;
+  gLed.cc = 1;
+  // request updates
+  gLed.needs_update = 1;
+}
@@ -0,0 +1,100 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+
+#ifndef LIST_MODE_H
+#define LIST_MODE_H
+
+#include <stdint.h>
+
+#include "settings.h"
+#include "cc_mode.h"
+
+// Max amount of steps in the list
+#define LIST_MODE_MAX_STEPS 16
+// Magic value marking initialized list in EEPROM
+#define LIST_MODE_MAGIC 0x4C53
+
+// List step type
+enum ListStepType_t : uint8_t
+{
+    LIST_STEP_OFF = 0, // output held off (dwell)
+    LIST_STEP_CV,      // constant voltage, setpoint in mV, limit is the current limit in mA
+    LIST_STEP_CC,      // constant current, setpoint in mA, limit is the voltage limit in mV
+    LIST_STEP_CV_RAMP, // constant voltage ramped linearly from the previous output voltage over the step duration
+    LIST_STEP_CC_RAMP, // constant current ramped linearly from the previous output current over the step duration
+    LIST_STEP_MAX      // not used
+};
+typedef enum ListStepType_t ListStepType_t;
+
+// List step
+typedef struct
+{
+    uint32_t duration_10ms; // step duration in 10ms
+    uint16_t setpoint;      // regulated voltage in mV or current in mA
+    uint16_t limit;         // current limit in mA (CV) or voltage limit in mV (CC), 0 for the hardware max
+    ListStepType_t type;    // step type
+} ListStep_t;
+
+// List program (stored in EEPROM)
+typedef struct
+{
+    uint16_t magic;                        // LIST_MODE_MAGIC when initialized
+    uint8_t count;                         // amount of steps
+    uint8_t repeat;                        // amount of passes through the list (0 - repeat forever)
+    ListStep_t steps[LIST_MODE_MAX_STEPS]; // steps
+} __attribute__((aligned(EEPROM_ALIGNMENT))) ListProgram_t;
+
+// list mode state machine
+enum ListModeState_t : uint8_t
+{
+    LIST_MODE_IDLE = 0, // output off or empty list
+    LIST_MODE_RUNNING,  // executing the steps
+    LIST_MODE_FINISHED  // all passes done, output off
+};
+typedef enum ListModeState_t ListModeState_t;
+
+// Main list mode struct
+typedef struct
+{
+    ListModeState_t state;
+    uint8_t step_index;            // index of the active step
+    uint8_t pass;                  // passes through the list completed
+    unsigned long step_start_10ms; // SYSTEM_10millis() at the start of the active step
+    ListStep_t step;               // active step
+    CcMode_t cc_mode;              // regulator, CV steps run it with the voltage loop in charge
+} ListMode_t;
+
+void LIST_MODE_Setup();
+void LIST_MODE_Init();
+void LIST_MODE_Tick();
+ListModeState_t LIST_MODE_GetState();
+uint8_t LIST_MODE_Step();
+void LIST_MODE_TimeSlice10ms();
+void LIST_MODE_TimeSlice100ms();
+void LIST_MODE_TimeSlice500ms();
+void LIST_MODE_TimeSlice1000ms();
+void LIST_MODE_ModeBtnPressed();
+void LIST_MODE_ModeBtnHeld();
+void LIST_MODE_OutputBtnPressed();
+void LIST_MODE_OutputBtnHeld();
+bool LIST_MODE_Add(ListStepType_t type, uint32_t setpoint, uint32_t limit, uint32_t duration_10ms);
+void LIST_MODE_SetRepeat(uint8_t repeat);
+void LIST_MODE_Clear();
+void LIST_MODE_Save();
+void LIST_MODE_Print();
+ListStepType_t LIST_MODE_FindType(const char *name);
+#endif
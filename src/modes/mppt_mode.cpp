@@ -20,6 +20,7 @@
 
 #include "app.h"
 #include "drivers/led.h"
+#include "mppt.h"
 #include <settings.h>
 
 static uint16_t mppt_voltage = TO_MILI(4.0);
@@ -36,7 +37,7 @@ void MPPT_MODE_Tick()
     return;
   }
   // if voltage is below target voltage and duty cycle can be increased
-  if ((gApp.input_voltage > mppt_voltage) && (gApp.duty_cycle < MAX_DUTY_CYCLE))
+  if ((gApp.input_voltage > mppt_voltage) && (gApp.duty_cycle < gApp.duty_ceiling))
   {
     gApp.duty_cycle += 1;
   }
@@ -79,14 +80,18 @@ void MPPT_MODE_ModeBtnHeld()
 }
 void MPPT_MODE_OutputBtnPressed()
 {
-  mppt_voltage += 100;
+  mppt_voltage += MPPT_STEP;
 #ifdef DEBUG_MODE
   Serial.println("mppt mode: output btn pressed");
 #endif
 }
 void MPPT_MODE_OutputBtnHeld()
 {
-  mppt_voltage -= 100;
+  // auto-repeat keeps lowering the target, stop at the tracker minimum
+  if (mppt_voltage >= MPPT_MIN_VOLTAGE + MPPT_STEP)
+  {
+    mppt_voltage -= MPPT_STEP;
+  }
 #ifdef DEBUG_MODE
   Serial.println("mppt mode: output btn held");
 #endif
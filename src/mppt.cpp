@@ -0,0 +1,81 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+
+#include "mppt.h"
+#include "app.h"
+
+/// @brief Initialize tracker, reference starts at a fraction of the open circuit input voltage
+/// @param mppt tracker
+/// @param open_circuit_voltage input voltage in mV measured with the converter off long enough to settle
+void MPPT_Init(Mppt_t *mppt, uint32_t open_circuit_voltage)
+{
+  uint32_t voltage = (open_circuit_voltage * MPPT_OPEN_CIRCUIT_RATIO) / 100;
+
+  mppt->voltage = (voltage > MPPT_MIN_VOLTAGE) ? voltage : MPPT_MIN_VOLTAGE;
+  mppt->direction = -1;
+  mppt->limiting = false;
+  mppt->samples = 0;
+  mppt->power = 0;
+  mppt->last_power = 0;
+}
+
+/// @brief Check if the source is loaded past its maximum power point, must be called every tick
+/// @param mppt tracker
+/// @return true if duty cycle has to be lowered
+bool MPPT_Limit(Mppt_t *mppt)
+{
+  if (gApp.input_voltage < mppt->voltage + MPPT_ACTIVE_BAND)
+  {
+    mppt->limiting = true;
+  }
+  return gApp.input_voltage < mppt->voltage;
+}
+
+/// @brief Move the reference toward the maximum power point by perturb and observe
+/// @param mppt tracker
+void MPPT_TimeSlice100ms(Mppt_t *mppt)
+{
+  mppt->power += (gApp.input_voltage * gApp.input_current) / 1000;
+  if (++mppt->samples < MPPT_PERIOD_100MS)
+  {
+    return;
+  }
+
+  uint32_t power = mppt->power / mppt->samples;
+
+  // reference only matters while the source limits the output, otherwise it would wander off
+  if (mppt->limiting)
+  {
+    // last step lowered the harvest - turn around
+    if (power < mppt->last_power)
+    {
+      mppt->direction = -mppt->direction;
+    }
+    if (mppt->direction > 0)
+    {
+      mppt->voltage += MPPT_STEP;
+    }
+    else if (mppt->voltage >= MPPT_MIN_VOLTAGE + MPPT_STEP)
+    {
+      mppt->voltage -= MPPT_STEP;
+    }
+  }
+  mppt->last_power = power;
+  mppt->limiting = false;
+  mppt->samples = 0;
+  mppt->power = 0;
+}
@@ -0,0 +1,50 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+
+#ifndef MPPT_H
+#define MPPT_H
+
+#include <stdint.h>
+
+#include "lib/util.h"
+
+// Lowest input voltage reference in mV
+#define MPPT_MIN_VOLTAGE TO_MILI(4.0)
+// Input voltage reference at start as percentage of the open circuit input voltage (Vmpp is about 80% of Voc)
+#define MPPT_OPEN_CIRCUIT_RATIO 80
+// Perturbation step of the input voltage reference in mV
+#define MPPT_STEP TO_MILI(0.1)
+// Perturb and observe period in 100ms
+#define MPPT_PERIOD_100MS 5
+// Input voltage band in mV above the reference where the tracker is considered in charge of the duty cycle
+#define MPPT_ACTIVE_BAND TO_MILI(0.3)
+
+// Perturb and observe maximum power point tracker
+typedef struct
+{
+    uint32_t voltage;    // input voltage reference in mV, duty cycle is lowered below it
+    int8_t direction;    // direction of the next perturbation (+1 / -1)
+    bool limiting;       // input voltage was within MPPT_ACTIVE_BAND of the reference during the period
+    uint8_t samples;     // input power samples taken during the period
+    uint32_t power;      // input power sum in mW over the period
+    uint32_t last_power; // average input power in mW over the previous period
+} Mppt_t;
+
+void MPPT_Init(Mppt_t *mppt, uint32_t open_circuit_voltage);
+bool MPPT_Limit(Mppt_t *mppt);
+void MPPT_TimeSlice100ms(Mppt_t *mppt);
+#endif
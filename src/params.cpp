@@ -0,0 +1,250 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#include <Arduino.h>
+
+#include "params.h"
+#include "settings.h"
+#include "lib/util.h"
+
+// Params must fit between EEPROM_PARAMS_ADDRESS and the next EEPROM region
+static_assert(sizeof(Params_t) <= EEPROM_FAULT_LOG_ADDRESS - EEPROM_PARAMS_ADDRESS, "Params_t does not fit its EEPROM region");
+
+// Global params variable
+Params_t gParams;
+
+// Local functions
+static void read_descriptor(uint8_t index, ParamDescriptor_t *descriptor);
+static uint32_t read_value(const ParamDescriptor_t *descriptor);
+static void write_value(const ParamDescriptor_t *descriptor, uint32_t value);
+
+// Parameter names
+static const char nameCvRipple[] PROGMEM = "cv_ripple";
+static const char nameCvSoftStartStep[] PROGMEM = "cv_ss_step";
+static const char nameCvSoftStartPeriod[] PROGMEM = "cv_ss_period";
+static const char nameCvSnub[] PROGMEM = "cv_snub";
+static const char nameCvSlew[] PROGMEM = "cv_slew";
+static const char nameCvCable[] PROGMEM = "cv_cable";
+static const char nameCvHiccup[] PROGMEM = "cv_hiccup";
+static const char nameCcRipple[] PROGMEM = "cc_ripple";
+static const char nameCcSoftStartStep[] PROGMEM = "cc_ss_step";
+static const char nameCcSoftStartPeriod[] PROGMEM = "cc_ss_period";
+static const char nameCcSnub[] PROGMEM = "cc_snub";
+static const char nameCcSlew[] PROGMEM = "cc_slew";
+static const char nameCcHiccup[] PROGMEM = "cc_hiccup";
+static const char nameCcCvHysteresis[] PROGMEM = "cc_cv_hyst";
+static const char nameCcCvRipple[] PROGMEM = "cc_cv_ripple";
+static const char nameChargeRipple[] PROGMEM = "chg_ripple";
+static const char nameChargeCvHysteresis[] PROGMEM = "chg_cv_hyst";
+static const char nameChargeCvRipple[] PROGMEM = "chg_cv_ripple";
+static const char nameChargeNegDeltaV[] PROGMEM = "chg_ndv";
+static const char nameChargePlateau[] PROGMEM = "chg_plateau";
+static const char nameChargeIrCompensation[] PROGMEM = "chg_ir_comp";
+static const char nameChargePrechargeCurrent[] PROGMEM = "chg_pre_pct";
+static const char nameChargePrechargeTime[] PROGMEM = "chg_pre_time";
+static const char nameChargeSolar[] PROGMEM = "chg_solar";
+static const char namePwmMode[] PROGMEM = "pwm_mode";
+static const char namePwmHighLoadMode[] PROGMEM = "pwm_hl_mode";
+static const char namePwmOptimise[] PROGMEM = "pwm_optimise";
+static const char namePwmBurst[] PROGMEM = "pwm_burst";
+
+// Tunable parameter descriptors
+static const ParamDescriptor_t descriptors[] PROGMEM = {
+    // name, type, min, max, default, value
+    {nameCvRipple, PARAM_TYPE_U32, TO_MILI(0.1), TO_MILI(5.0), TO_MILI(2.2), &gParams.cv_mode.max_voltage_ripple},
+    {nameCvSoftStartStep, PARAM_TYPE_U32, 0, TO_MILI(1.0), TO_MILI(0.001), &gParams.cv_mode.soft_start_step_up_voltage},
+    {nameCvSoftStartPeriod, PARAM_TYPE_U8, 0, 100, 5, &gParams.cv_mode.soft_start_period_10ms},
+    {nameCvSnub, PARAM_TYPE_U8, 0, 100, 3, &gParams.cv_mode.snub_power},
+    {nameCvSlew, PARAM_TYPE_U16, 0, TO_MILI(1.0), 20, &gParams.cv_mode.slew_rate},
+    {nameCvCable, PARAM_TYPE_U16, 0, 2000, 0, &gParams.cv_mode.cable_resistance},
+    {nameCvHiccup, PARAM_TYPE_U16, 0, 1000, 50, &gParams.cv_mode.hiccup_off_10ms},
+    {nameCcRipple, PARAM_TYPE_U32, TO_MILI(0.01), TO_MILI(2.0), TO_MILI(1.0), &gParams.cc_mode.max_current_ripple},
+    {nameCcSoftStartStep, PARAM_TYPE_U32, 0, TO_MILI(1.0), TO_MILI(0.001), &gParams.cc_mode.soft_start_step_up_current},
+    {nameCcSoftStartPeriod, PARAM_TYPE_U8, 0, 100, 5, &gParams.cc_mode.soft_start_period_10ms},
+    {nameCcSnub, PARAM_TYPE_U8, 0, 100, 3, &gParams.cc_mode.snub_power},
+    {nameCcSlew, PARAM_TYPE_U16, 0, TO_MILI(1.0), 10, &gParams.cc_mode.slew_rate},
+    {nameCcHiccup, PARAM_TYPE_U16, 0, 1000, 50, &gParams.cc_mode.hiccup_off_10ms},
+    {nameCcCvHysteresis, PARAM_TYPE_U16, 0, TO_MILI(1.0), 0, &gParams.cc_mode.cv_mode_switch_hysteresis},
+    {nameCcCvRipple, PARAM_TYPE_U32, TO_MILI(0.1), TO_MILI(5.0), TO_MILI(2.0), &gParams.cc_mode.cv_max_voltage_ripple},
+    {nameChargeRipple, PARAM_TYPE_U32, TO_MILI(0.01), TO_MILI(2.0), TO_MILI(1.0), &gParams.charge_mode.max_current_ripple},
+    {nameChargeCvHysteresis, PARAM_TYPE_U16, 0, TO_MILI(1.0), 20, &gParams.charge_mode.cv_mode_switch_hysteresis},
+    {nameChargeCvRipple, PARAM_TYPE_U32, TO_MILI(0.1), TO_MILI(5.0), TO_MILI(4.0), &gParams.charge_mode.cv_max_voltage_ripple},
+    {nameChargeNegDeltaV, PARAM_TYPE_U8, 1, 50, 5, &gParams.charge_mode.neg_delta_v},
+    {nameChargePlateau, PARAM_TYPE_U8, 0, 120, 20, &gParams.charge_mode.plateau_min},
+    {nameChargeIrCompensation, PARAM_TYPE_U8, 0, 100, 50, &gParams.charge_mode.ir_compensation},
+    {nameChargePrechargeCurrent, PARAM_TYPE_U8, 1, 100, 10, &gParams.charge_mode.precharge_current},
+    {nameChargePrechargeTime, PARAM_TYPE_U8, 1, 240, 30, &gParams.charge_mode.precharge_min},
+    {nameChargeSolar, PARAM_TYPE_U8, 0, 1, 0, &gParams.charge_mode.solar},
+    {namePwmMode, PARAM_TYPE_U8, PWM_MODE_FAST_PWM_15KHZ, PWM_MODE_PC_PWM_125KHZ, PWM_MODE_DEFAULT, &gParams.pwm.mode},
+    {namePwmHighLoadMode, PARAM_TYPE_U8, PWM_MODE_FAST_PWM_15KHZ, PWM_MODE_PC_PWM_125KHZ, PWM_STEP_DOWN_MODE_HIGH_LOAD, &gParams.pwm.high_load_mode},
+    {namePwmOptimise, PARAM_TYPE_U8, 0, 1, 0, &gParams.pwm.optimise},
+    {namePwmBurst, PARAM_TYPE_U8, 0, 1, 0, &gParams.pwm.burst},
+};
+
+/// @brief Load params from EEPROM, falling back to defaults for malformed values
+void PARAMS_Load()
+{
+  ParamDescriptor_t descriptor;
+
+  SETTINGS_Read(EEPROM_PARAMS_ADDRESS, &gParams, sizeof(gParams));
+
+  // Never saved or layout changed - use defaults
+  if (gParams.magic != PARAMS_MAGIC)
+  {
+    PARAMS_Reset();
+    return;
+  }
+
+  // Set default values if data is malformed
+  for (uint8_t i = 0; i < PARAMS_Count(); i++)
+  {
+    read_descriptor(i, &descriptor);
+    uint32_t value = read_value(&descriptor);
+    if (value < descriptor.min || value > descriptor.max)
+    {
+      write_value(&descriptor, descriptor.def);
+    }
+  }
+#ifdef DEBUG_MODE
+  Serial.println("PARAMS loaded");
+#endif
+}
+
+/// @brief Save params to EEPROM
+void PARAMS_Save()
+{
+  gParams.magic = PARAMS_MAGIC;
+  SETTINGS_Write(EEPROM_PARAMS_ADDRESS, &gParams, sizeof(gParams));
+#ifdef DEBUG_MODE
+  Serial.println("PARAMS saved");
+#endif
+}
+
+/// @brief Reset all params to defaults
+void PARAMS_Reset()
+{
+  ParamDescriptor_t descriptor;
+
+  for (uint8_t i = 0; i < PARAMS_Count(); i++)
+  {
+    read_descriptor(i, &descriptor);
+    write_value(&descriptor, descriptor.def);
+  }
+}
+
+/// @brief Get number of tunable params
+/// @return params count
+uint8_t PARAMS_Count()
+{
+  return sizeof(descriptors) / sizeof(descriptors[0]);
+}
+
+/// @brief Find param by name
+/// @param name param name
+/// @return param index or -1 if not found
+int8_t PARAMS_Find(const char *name)
+{
+  for (uint8_t i = 0; i < PARAMS_Count(); i++)
+  {
+    if (strcmp_P(name, (const char *)pgm_read_ptr(&descriptors[i].name)) == 0)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/// @brief Get param value
+/// @param index param index
+/// @return param value
+uint32_t PARAMS_Get(uint8_t index)
+{
+  ParamDescriptor_t descriptor;
+
+  read_descriptor(index, &descriptor);
+  return read_value(&descriptor);
+}
+
+/// @brief Set param value, rejects values outside of the param range
+/// @param index param index
+/// @param value new value
+/// @return true if value was accepted
+bool PARAMS_Set(uint8_t index, uint32_t value)
+{
+  ParamDescriptor_t descriptor;
+
+  read_descriptor(index, &descriptor);
+  if (value < descriptor.min || value > descriptor.max)
+  {
+    return false;
+  }
+  write_value(&descriptor, value);
+  return true;
+}
+
+/// @brief Print param in "name=value [min..max]" format
+/// @param index param index
+void PARAMS_Print(uint8_t index)
+{
+  ParamDescriptor_t descriptor;
+
+  read_descriptor(index, &descriptor);
+  Serial.print((const __FlashStringHelper *)descriptor.name);
+  Serial.print('=');
+  Serial.print(read_value(&descriptor));
+  Serial.print(F(" ["));
+  Serial.print(descriptor.min);
+  Serial.print(F(".."));
+  Serial.print(descriptor.max);
+  Serial.println(']');
+}
+
+// Copy descriptor from flash
+static void read_descriptor(uint8_t index, ParamDescriptor_t *descriptor)
+{
+  memcpy_P(descriptor, &descriptors[index], sizeof(ParamDescriptor_t));
+}
+
+// Read value pointed by the descriptor
+static uint32_t read_value(const ParamDescriptor_t *descriptor)
+{
+  switch (descriptor->type)
+  {
+  case PARAM_TYPE_U8:
+    return *(uint8_t *)descriptor->value;
+  case PARAM_TYPE_U16:
+    return *(uint16_t *)descriptor->value;
+  default:
+    return *(uint32_t *)descriptor->value;
+  }
+}
+
+// Write value pointed by the descriptor
+static void write_value(const ParamDescriptor_t *descriptor, uint32_t value)
+{
+  switch (descriptor->type)
+  {
+  case PARAM_TYPE_U8:
+    *(uint8_t *)descriptor->value = value;
+    break;
+  case PARAM_TYPE_U16:
+    *(uint16_t *)descriptor->value = value;
+    break;
+  default:
+    *(uint32_t *)descriptor->value = value;
+    break;
+  }
+}
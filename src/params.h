@@ -0,0 +1,117 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include <stdint.h>
+
+#include "settings.h"
+#include "drivers/pwm.h"
+
+// Magic value stored with the params in EEPROM, change it whenever Params_t layout changes
+#define PARAMS_MAGIC 0x5041520B
+
+// Tunable parameter value type
+enum ParamType_t : uint8_t
+{
+    PARAM_TYPE_U8 = 0, // uint8_t value
+    PARAM_TYPE_U16,    // uint16_t value
+    PARAM_TYPE_U32     // uint32_t value
+};
+typedef enum ParamType_t ParamType_t;
+
+// CV mode tunable params
+typedef struct
+{
+    uint32_t max_voltage_ripple;         // max output voltage ripple in mV before snubbing
+    uint32_t soft_start_step_up_voltage; // soft start step up in mV
+    uint16_t slew_rate;                  // max target voltage change in mV per 10ms on live setting changes (0 - no limit)
+    uint16_t cable_resistance;           // output cable resistance in mOhm compensated in CV mode (0 - off)
+    uint16_t hiccup_off_10ms;            // output off time in 10ms after a short circuit (0 - no hiccup foldback)
+    uint8_t soft_start_period_10ms;      // delay in 10ms between soft start regulations
+    uint8_t snub_power;                  // snubbing target voltage drop percentage (0-100%)
+} CvModeParams_t;
+
+// CC mode tunable params
+typedef struct
+{
+    uint32_t max_current_ripple;         // max output current ripple in mA before snubbing
+    uint32_t soft_start_step_up_current; // soft start step up in mA
+    uint32_t cv_max_voltage_ripple;      // max output voltage ripple in mV of the CV limit loop
+    uint16_t cv_mode_switch_hysteresis;  // hysteresis in mV for switching to CV mode
+    uint16_t slew_rate;                  // max target current change in mA per 10ms on live setting changes (0 - no limit)
+    uint16_t hiccup_off_10ms;            // output off time in 10ms after a short circuit (0 - no hiccup foldback)
+    uint8_t soft_start_period_10ms;      // delay in 10ms between soft start regulations
+    uint8_t snub_power;                  // snubbing target current drop percentage (0-100%)
+} CcModeParams_t;
+
+// CHARGE mode tunable params
+typedef struct
+{
+    uint32_t max_current_ripple;        // max output current ripple in mA before snubbing
+    uint32_t cv_max_voltage_ripple;     // max output voltage ripple in mV of the CV limit loop
+    uint16_t cv_mode_switch_hysteresis; // hysteresis in mV for CC->CV switch near end of charge
+    uint8_t neg_delta_v;                // battery voltage drop in mV below its peak terminating -dV charge stages
+    uint8_t plateau_min;                // minutes without new battery voltage peak terminating -dV charge stages (0 - off)
+    uint8_t ir_compensation;            // share in % of the estimated I*R drop added to the stage voltage limit
+    uint8_t precharge_current;          // pre-charge current in % of the charge current
+    uint8_t precharge_min;              // minutes the battery has to recover to the profile minimum voltage in pre-charge
+    uint8_t solar;                      // track input maximum power point while charging (0 - off, 1 - on)
+} ChargeModeParams_t;
+
+// PWM tunable params
+typedef struct
+{
+    PWM_MODE_t mode;           // default PWM mode (switching frequency)
+    PWM_MODE_t high_load_mode; // PWM mode activated under high load in step-down mode
+    uint8_t optimise;          // pick the most efficient switching frequency by measurement (0 - off, 1 - on)
+    uint8_t burst;             // run in bursts at light load (0 - off, 1 - on)
+} PwmParams_t;
+
+// PARAMS values
+typedef struct
+{
+    uint32_t magic;                                      // PARAMS_MAGIC when EEPROM contents are valid
+    CvModeParams_t cv_mode;                              // CV mode tunables
+    CcModeParams_t cc_mode;                              // CC mode tunables
+    ChargeModeParams_t charge_mode;                      // CHARGE mode tunables
+    PwmParams_t pwm;                                     // PWM tunables
+} __attribute__((aligned(EEPROM_ALIGNMENT))) Params_t; // auto-align
+
+// Tunable parameter descriptor (stored in flash)
+typedef struct
+{
+    const char *name; // parameter name (stored in flash)
+    ParamType_t type; // value type
+    uint32_t min;     // minimum allowed value
+    uint32_t max;     // maximum allowed value
+    uint32_t def;     // default value
+    void *value;      // pointer to the value inside gParams
+} ParamDescriptor_t;
+
+// Global params variable
+extern Params_t gParams;
+
+void PARAMS_Load();
+void PARAMS_Save();
+void PARAMS_Reset();
+uint8_t PARAMS_Count();
+int8_t PARAMS_Find(const char *name);
+uint32_t PARAMS_Get(uint8_t index);
+bool PARAMS_Set(uint8_t index, uint32_t value);
+void PARAMS_Print(uint8_t index);
+#endif
@@ -0,0 +1,182 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#include <Arduino.h>
+#include <WDT.h>
+#include <lgt_LowPower.h>
+
+#include "power.h"
+#include "app.h"
+#include "event.h"
+#include "settings.h"
+#include "system.h"
+#include "drivers/adc.h"
+#include "drivers/button.h"
+#include "drivers/led.h"
+#include "drivers/pwm.h"
+#include "modes/error_mode.h"
+
+// Local functions
+static bool converter_idle();
+static bool can_power_down();
+static void suspend();
+static void resume();
+static void power_down();
+
+static Power_t power;
+
+// Interrupt handler for button pin change, only used to wake up from power down
+ISR(PCINT2_vect)
+{
+}
+
+/// @brief Suspend converter and sleep until next interrupt when there is nothing to regulate
+void POWER_Tick()
+{
+  bool idle = converter_idle();
+
+  if (idle != power.suspended)
+  {
+    idle ? suspend() : resume();
+  }
+
+  // events queued since the queue was drained are handled in the next loop
+  if (power.suspended && !EVENT_Pending())
+  {
+    // TIMER2 wakes us up for the next 10ms tick, buttons and serial wake us up earlier
+    // note: if TIMER2 fired right before entering sleep, the next time slice is delayed by one tick
+    LowPower.idle(SLEEP_FOREVER, ADC_OFF, TIMER3_OFF, TIMER2_ON, TIMER1_OFF, TIMER0_OFF,
+                  SPI_OFF, USART0_ON, TWI_OFF, PCIC_ON, FLASHCTL_ON);
+  }
+}
+
+void POWER_TimeSlice10ms()
+{
+  if (!power.suspended)
+  {
+    return;
+  }
+
+  if (power.inactive_10ms < POWER_DOWN_TIMEOUT_10MS)
+  {
+    power.inactive_10ms++;
+  }
+  else if (can_power_down())
+  {
+    power_down();
+  }
+}
+
+/// @brief Report user activity, postpones power down
+void POWER_Activity()
+{
+  power.inactive_10ms = 0;
+}
+
+// Check if converter has nothing to regulate
+static bool converter_idle()
+{
+  switch (gSettings.mode)
+  {
+  case APP_MODE_IDLE:
+  case APP_MODE_ERROR:
+    return true;
+  case APP_MODE_CALIBRATION:
+    // calibration keeps the converter running
+    return false;
+  default:
+    return !gSettings.output;
+  }
+}
+
+// Check if nothing would be lost by stopping TIMER2
+static bool can_power_down()
+{
+  // pending recovery needs the system clock
+  if (gSettings.mode == APP_MODE_ERROR && !ERROR_MODE_IsLatched())
+  {
+    return false;
+  }
+  // let the EEPROM writes finish first
+  return gSettingsSaveIn1000ms == 0 && !SETTINGS_WriteBusy();
+}
+
+// Stop the converter clocks
+static void suspend()
+{
+  ADC_SetAutoTrigger(false);
+  PWM_Suspend();
+  power.suspended = true;
+  power.inactive_10ms = 0;
+#ifdef DEBUG_MODE
+  Serial.println(F("power: suspended"));
+#endif
+}
+
+// Restart the converter clocks
+static void resume()
+{
+  PWM_Resume();
+  ADC_SetAutoTrigger(true);
+  power.suspended = false;
+#ifdef DEBUG_MODE
+  Serial.println(F("power: resumed"));
+#endif
+}
+
+// Turn off LEDs and ADC and sleep until a button is pressed
+static void power_down()
+{
+#ifdef DEBUG_MODE
+  Serial.println(F("power: down"));
+  Serial.flush();
+#endif
+  // turn off LEDs
+  LED_Clear();
+  LED_TimeSlice10ms();
+
+  // watchdog would reset us during sleep
+  wdt_disable();
+
+  // wake up on any button pin change
+  noInterrupts();
+  PCMSK2 |= POWER_WAKE_PCMSK2;
+  PCIFR = 1 << PCIF2;
+  PCICR |= 1 << PCIE2;
+  interrupts();
+
+  LowPower.powerDown(SLEEP_FOREVER, ADC_OFF, BOD_OFF);
+
+  noInterrupts();
+  PCICR &= ~(1 << PCIE2);
+  PCMSK2 &= ~POWER_WAKE_PCMSK2;
+  interrupts();
+  // the wake up press is not passed to the mode
+  BUTTON_IgnoreHeld();
+
+#ifdef DEBUG_MODE
+  wdt_enable(SYSTEM_WATCHDOG_TIMEOUT_DEBUG_MODE);
+#else
+  wdt_enable(SYSTEM_WATCHDOG_TIMEOUT);
+#endif
+
+  power.inactive_10ms = 0;
+  // restore LEDs
+  APP_InitCurrentApp();
+#ifdef DEBUG_MODE
+  Serial.println(F("power: woke up"));
+#endif
+}
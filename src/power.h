@@ -0,0 +1,38 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+// Inactivity time in 10ms after which the device powers down
+#define POWER_DOWN_TIMEOUT_10MS 3000 // 3000*10ms = 30s
+// Pin change interrupt mask of the buttons, used to wake up from power down
+// BUTTON_PIN_MODE (D2) is PCINT18, BUTTON_PIN_OUTPUT (D3) is PCINT19
+#define POWER_WAKE_PCMSK2 ((1 << PCINT18) | (1 << PCINT19))
+
+// Power manager struct
+typedef struct
+{
+    bool suspended;           // converter clocks are stopped and MCU sleeps between ticks
+    uint16_t inactive_10ms;   // time in 10ms since last user activity while suspended
+} Power_t;
+
+void POWER_Tick();
+void POWER_TimeSlice10ms();
+void POWER_Activity();
+#endif
@@ -0,0 +1,120 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#include <Arduino.h>
+
+#include "protection.h"
+#include "app.h"
+
+// Local functions
+static uint32_t input_current();
+static uint32_t output_current();
+static uint32_t output_voltage();
+static uint32_t vin_plus_vout();
+static uint32_t squares_difference(uint32_t high, uint32_t low, uint32_t limit);
+
+// Protected quantities
+static const ProtectionEntry_t protectionTable[] = {
+    // read, limit, hard limit, trip threshold, cause
+    {input_current, MAX_INPUT_CURRENT, INPUT_CURRENT_HARD_LIMIT, INPUT_CURRENT_TRIP_THRESHOLD, FAULT_CAUSE_INPUT_OVERCURRENT},
+    {output_current, MAX_OUTPUT_CURRENT, OUTPUT_CURRENT_HARD_LIMIT, OUTPUT_CURRENT_TRIP_THRESHOLD, FAULT_CAUSE_OUTPUT_OVERCURRENT},
+    {output_voltage, MAX_OUTPUT_VOLTAGE, OUTPUT_VOLTAGE_HARD_LIMIT, OUTPUT_VOLTAGE_TRIP_THRESHOLD, FAULT_CAUSE_OUTPUT_OVERVOLTAGE},
+    {vin_plus_vout, VIN_PLUS_VOUT_HARD_LIMIT, VIN_PLUS_VOUT_HARD_LIMIT, VIN_PLUS_VOUT_TRIP_THRESHOLD, FAULT_CAUSE_DIODE_REVERSE_VOLTAGE},
+};
+
+#define PROTECTION_TABLE_SIZE (sizeof(protectionTable) / sizeof(protectionTable[0]))
+
+// Overload accumulators, never cleared - they cool down below the limit (i.e. while error mode holds the output off),
+// so switching modes or restarting the output can't hide a repeated overload
+static uint32_t accumulators[PROTECTION_TABLE_SIZE];
+
+/// @brief Check instantaneous (hard) limits, runs every tick so it only does comparisons
+/// @return fault cause or FAULT_CAUSE_NONE
+FaultCause_t PROTECTION_Tick()
+{
+  for (uint8_t i = 0; i < PROTECTION_TABLE_SIZE; i++)
+  {
+    if (protectionTable[i].read() > protectionTable[i].hard_limit)
+    {
+      return protectionTable[i].cause;
+    }
+  }
+  return FAULT_CAUSE_NONE;
+}
+
+/// @brief Update inverse-time accumulators, runs every 10ms
+/// @return fault cause or FAULT_CAUSE_NONE
+FaultCause_t PROTECTION_TimeSlice10ms()
+{
+  FaultCause_t cause = FAULT_CAUSE_NONE;
+
+  for (uint8_t i = 0; i < PROTECTION_TABLE_SIZE; i++)
+  {
+    const ProtectionEntry_t *entry = &protectionTable[i];
+    uint32_t value = entry->read();
+
+    if (value > entry->limit)
+    {
+      // heat up
+      accumulators[i] += squares_difference(value, entry->limit, entry->limit);
+      if (accumulators[i] >= entry->trip_threshold)
+      {
+        // saturate, so cooling down always takes bounded time
+        accumulators[i] = entry->trip_threshold;
+        if (cause == FAULT_CAUSE_NONE)
+        {
+          cause = entry->cause;
+        }
+      }
+    }
+    else
+    {
+      // cool down
+      uint32_t headroom = squares_difference(entry->limit, value, entry->limit);
+      accumulators[i] = (accumulators[i] > headroom) ? accumulators[i] - headroom : 0;
+    }
+  }
+  return cause;
+}
+
+static uint32_t input_current()
+{
+  return gApp.input_current;
+}
+
+static uint32_t output_current()
+{
+  return gApp.output_current;
+}
+
+static uint32_t output_voltage()
+{
+  return gApp.output_voltage;
+}
+
+static uint32_t vin_plus_vout()
+{
+  return gApp.input_voltage + gApp.output_voltage;
+}
+
+// Returns (high^2 - low^2) / limit, high must be >= low
+static uint32_t squares_difference(uint32_t high, uint32_t low, uint32_t limit)
+{
+  // values are up to 16 bit so squares fit 32 bits, except for sums of two values
+  high = (high > UINT16_MAX) ? UINT16_MAX : high;
+  low = (low > high) ? high : low;
+  return ((high * high) - (low * low)) / limit;
+}
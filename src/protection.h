@@ -0,0 +1,61 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef PROTECTION_H
+#define PROTECTION_H
+
+#include <stdint.h>
+
+#include "fault_log.h"
+
+// Inverse-time protection:
+// every 10ms each quantity above its continuous limit accumulates overload = (value^2 - limit^2) / limit,
+// below the limit the accumulator cools down by the same formula. Protection trips once the accumulator
+// reaches the trip threshold, so the trip time is roughly threshold / overload * 10ms - short excursions
+// like capacitive inrush are tolerated while hard overloads trip fast. Values above the hard limit trip immediately.
+
+// Input current instantaneous trip limit in mA
+#define INPUT_CURRENT_HARD_LIMIT (MAX_INPUT_CURRENT * 2)
+// Input current trip threshold (120% trips in ~100ms, 150% in ~35ms)
+#define INPUT_CURRENT_TRIP_THRESHOLD 6600
+// Output current instantaneous trip limit in mA
+#define OUTPUT_CURRENT_HARD_LIMIT (MAX_OUTPUT_CURRENT * 2)
+// Output current trip threshold (120% trips in ~100ms, 150% in ~35ms)
+#define OUTPUT_CURRENT_TRIP_THRESHOLD 8800
+// Output voltage instantaneous trip limit in mV (just below the max voltage the ADC can read)
+#define OUTPUT_VOLTAGE_HARD_LIMIT TO_MILI(17.4)
+// Output voltage trip threshold (17.2V trips in ~30ms)
+#define OUTPUT_VOLTAGE_TRIP_THRESHOLD 1800
+// Vin+Vout instantaneous trip limit in mV - diode reverse voltage is an absolute maximum rating, no overload is tolerated,
+// trips once Vin+Vout reaches MAX_VIN_PLUS_VOUT
+#define VIN_PLUS_VOUT_HARD_LIMIT (MAX_VIN_PLUS_VOUT - 1)
+// Vin+Vout trip threshold (continuous limit equals the hard limit, the accumulator never runs)
+#define VIN_PLUS_VOUT_TRIP_THRESHOLD 0
+
+// Protected quantity
+typedef struct
+{
+    uint32_t (*read)();      // returns measured value
+    uint32_t limit;          // continuous limit, overload accumulates above it
+    uint32_t hard_limit;     // instantaneous trip limit
+    uint32_t trip_threshold; // accumulated overload which trips the protection
+    FaultCause_t cause;      // fault cause reported on trip
+} ProtectionEntry_t;
+
+FaultCause_t PROTECTION_Tick();
+FaultCause_t PROTECTION_TimeSlice10ms();
+
+#endif
@@ -0,0 +1,121 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#include "setpoint.h"
+#include "app.h"
+
+/// @brief Get max output voltage allowed by the live input voltage and the diode reverse voltage budget
+/// @return max output voltage in mV
+uint32_t SETPOINT_MaxOutputVoltage()
+{
+  uint32_t budget = MAX_VIN_PLUS_VOUT - SETPOINT_VIN_PLUS_VOUT_HEADROOM;
+
+  if (gApp.input_voltage >= budget)
+  {
+    return 0;
+  }
+  budget -= gApp.input_voltage;
+  return (budget < MAX_OUTPUT_VOLTAGE) ? budget : MAX_OUTPUT_VOLTAGE;
+}
+
+/// @brief Check if output voltage target can be applied at current input voltage
+/// @param voltage target output voltage in mV
+/// @return true if target is admissible
+bool SETPOINT_AdmitVoltage(uint32_t voltage)
+{
+  return voltage <= SETPOINT_MaxOutputVoltage();
+}
+
+/// @brief Lower output voltage target to the admissible maximum
+/// @param voltage target output voltage in mV
+/// @return admissible target output voltage in mV
+uint32_t SETPOINT_ClampVoltage(uint32_t voltage)
+{
+  uint32_t max_voltage = SETPOINT_MaxOutputVoltage();
+
+  return (voltage < max_voltage) ? voltage : max_voltage;
+}
+
+/// @brief Get next voltage setting in given direction, skipping settings not admissible at current input voltage
+/// @param voltage current voltage setting
+/// @param up true to go up, false to go down
+/// @param wrap true to wrap around at the ends, false to stay at the last admissible setting
+/// @param toMv function converting voltage setting to mV
+/// @return next admissible voltage setting, lowest setting if none is admissible
+CvModeVoltage_t SETPOINT_NextVoltageSetting(CvModeVoltage_t voltage, bool up, bool wrap, SetpointVoltageToMv_t toMv)
+{
+  uint8_t setting = voltage;
+
+  for (uint8_t i = 0; i < CV_MODE_VOLTAGE_MAX; i++)
+  {
+    // reached the end without wrapping - keep current setting if it is admissible
+    if (!wrap && (up ? setting + 1 >= CV_MODE_VOLTAGE_MAX : setting <= CV_MODE_VOLTAGE_1_5V))
+    {
+      break;
+    }
+    if (up)
+    {
+      setting = (setting + 1 < CV_MODE_VOLTAGE_MAX) ? setting + 1 : CV_MODE_VOLTAGE_1_5V;
+    }
+    else
+    {
+      setting = (setting > CV_MODE_VOLTAGE_1_5V) ? setting - 1 : CV_MODE_VOLTAGE_MAX - 1;
+    }
+
+    if (SETPOINT_AdmitVoltage(toMv((CvModeVoltage_t)setting)))
+    {
+      return (CvModeVoltage_t)setting;
+    }
+  }
+  if (!wrap && SETPOINT_AdmitVoltage(toMv(voltage)))
+  {
+    return voltage;
+  }
+  return CV_MODE_VOLTAGE_1_5V;
+}
+
+/// @brief Get duty cycle ceiling for the operating point - ideal CCM SEPIC duty cycle D = Vout / (Vin + Vout)
+/// for the target output voltage with margin for losses, walked down while inductor current is over its limit
+/// @param ceiling ceiling in use, rises by at most one step per call so the limit doesn't bounce
+/// @return new duty cycle ceiling
+uint8_t SETPOINT_DutyCeiling(uint8_t ceiling)
+{
+  uint32_t duty = MAX_DUTY_CYCLE;
+
+  // without output voltage target (i.e. MPPT) only the inductor current limit applies
+  if (gApp.target_voltage > 0)
+  {
+    duty = (MAX_PWM_RESOLUTION * gApp.target_voltage * SETPOINT_DUTY_CEILING_MARGIN) / ((gApp.input_voltage + gApp.target_voltage) * 100);
+    duty += SETPOINT_DUTY_CEILING_HEADROOM;
+    if (duty > MAX_DUTY_CYCLE)
+    {
+      duty = MAX_DUTY_CYCLE;
+    }
+  }
+
+  // inductor current over its limit - keep the ceiling below the duty cycle in use
+  if (gApp.input_current > SETPOINT_INDUCTOR_CURRENT_LIMIT)
+  {
+    uint8_t limit = (gApp.duty_cycle > MIN_DUTY_CYCLE) ? gApp.duty_cycle - 1 : MIN_DUTY_CYCLE;
+    return (duty < limit) ? duty : limit;
+  }
+
+  if (duty > (uint32_t)ceiling + 1)
+  {
+    duty = ceiling + 1;
+  }
+  return duty;
+}
@@ -0,0 +1,43 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef SETPOINT_H
+#define SETPOINT_H
+
+#include <stdint.h>
+
+#include "settings.h"
+#include "lib/util.h"
+
+// Margin in mV kept below MAX_VIN_PLUS_VOUT, so input voltage ripple does not trip the protection
+#define SETPOINT_VIN_PLUS_VOUT_HEADROOM TO_MILI(1.0)
+
+// Duty cycle ceiling - margin in % over the ideal CCM duty cycle, covers conversion losses
+#define SETPOINT_DUTY_CEILING_MARGIN 150
+// Duty cycle ceiling - headroom in duty cycle steps added on top, so regulation can always overshoot slightly
+#define SETPOINT_DUTY_CEILING_HEADROOM 5
+// Duty cycle ceiling - input (inductor) current in mA above which the ceiling is walked down
+#define SETPOINT_INDUCTOR_CURRENT_LIMIT MAX_INPUT_CURRENT
+
+// Converts voltage setting to mV
+typedef uint32_t (*SetpointVoltageToMv_t)(CvModeVoltage_t voltage);
+
+uint32_t SETPOINT_MaxOutputVoltage();
+bool SETPOINT_AdmitVoltage(uint32_t voltage);
+uint32_t SETPOINT_ClampVoltage(uint32_t voltage);
+CvModeVoltage_t SETPOINT_NextVoltageSetting(CvModeVoltage_t voltage, bool up, bool wrap, SetpointVoltageToMv_t toMv);
+uint8_t SETPOINT_DutyCeiling(uint8_t ceiling);
+#endif
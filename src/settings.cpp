@@ -19,20 +19,33 @@
 #include "settings.h"
 #include "system.h"
 
+// Settings must fit between EEPROM_ADDRESS and the next EEPROM region
+static_assert(sizeof(SettingsVal_t) <= EEPROM_PARAMS_ADDRESS - EEPROM_ADDRESS, "SettingsVal_t does not fit its EEPROM region");
+
 // Global eeprom variable
 SettingsVal_t gSettings;
 // Countdown timer
 uint8_t gSettingsSaveIn1000ms = 0;
+// Asynchronous write queue
+static SettingsWriteJob_t writeQueue[SETTINGS_WRITE_QUEUE_SIZE];
+static uint8_t writeQueueHead, writeQueueCount = 0;
 
 // Local functions
 static void save_settings_scheduler_1000ms();
+static void write_scheduler_10ms();
 
 /// @brief Load settings
 void SETTINGS_Load()
 {
-  lgt_eeprom_readSWM(EEPROM_ADDRESS, (uint32_t *)&gSettings, sizeof(gSettings) / EEPROM_ALIGNMENT);
+  SETTINGS_Read(EEPROM_ADDRESS, &gSettings, sizeof(gSettings));
   // Set default values if data is malformed
   gSettings.mode = (gSettings.mode < APP_MODE_MAX) ? gSettings.mode : APP_MODE_IDLE;
+  // list is started from the console only, don't resume it unattended after a power cycle
+  if (gSettings.mode == APP_MODE_LIST)
+  {
+    gSettings.mode = APP_MODE_IDLE;
+    gSettings.output = 0;
+  }
   gSettings.cv_mode.voltage = (gSettings.cv_mode.voltage < CV_MODE_VOLTAGE_MAX) ? gSettings.cv_mode.voltage : CV_MODE_VOLTAGE_1_5V;
   gSettings.cc_mode.current = (gSettings.cc_mode.current < CC_MODE_CURRENT_MAX) ? gSettings.cc_mode.current : CC_MODE_CURRENT_2MA;
   gSettings.cc_mode.voltage = (gSettings.cc_mode.voltage < CV_MODE_VOLTAGE_MAX) ? gSettings.cc_mode.voltage : CV_MODE_VOLTAGE_1_5V;
@@ -42,19 +55,95 @@ void SETTINGS_Load()
 }
 
 void SETTINGS_Save()
+{
+  SETTINGS_Write(EEPROM_ADDRESS, &gSettings, sizeof(gSettings));
+#ifdef DEBUG_MODE
+  Serial.println("SETTINGS saved");
+#endif
+}
+
+/// @brief Read EEPROM region
+/// @param address EEPROM address (must be EEPROM_ALIGNMENT aligned)
+/// @param data destination buffer
+/// @param size size in bytes (must be multiple of EEPROM_ALIGNMENT)
+void SETTINGS_Read(uint16_t address, void *data, uint8_t size)
+{
+  lgt_eeprom_readSWM(address, (uint32_t *)data, size / EEPROM_ALIGNMENT);
+}
+
+/// @brief Write EEPROM region
+/// @param address EEPROM address (must be EEPROM_ALIGNMENT aligned)
+/// @param data source buffer
+/// @param size size in bytes (must be multiple of EEPROM_ALIGNMENT)
+void SETTINGS_Write(uint16_t address, void *data, uint8_t size)
 {
   // Split saving into smaller chunks and perform SYSTEM_Tick() in between
   // to prevent WDT reset
-  uint8_t *ptr = (uint8_t *)&gSettings;
+  uint8_t *ptr = (uint8_t *)data;
 
-  for (uint8_t i = 0; i < (sizeof(gSettings) / EEPROM_ALIGNMENT); i++)
+  for (uint8_t i = 0; i < (size / EEPROM_ALIGNMENT); i++)
   {
-    lgt_eeprom_writeSWM(EEPROM_ADDRESS + (i * EEPROM_ALIGNMENT), (uint32_t *)(ptr + (i * EEPROM_ALIGNMENT)), 1);
+    lgt_eeprom_writeSWM(address + (i * EEPROM_ALIGNMENT), (uint32_t *)(ptr + (i * EEPROM_ALIGNMENT)), 1);
     SYSTEM_Tick();
   }
-#ifdef DEBUG_MODE
-  Serial.println("SETTINGS saved");
-#endif
+}
+
+/// @brief Queue EEPROM region write performed in the background, one word per 10ms.
+/// The data must stay valid until the write is finished.
+/// @param address EEPROM address (must be EEPROM_ALIGNMENT aligned)
+/// @param data source buffer
+/// @param size size in bytes (must be multiple of EEPROM_ALIGNMENT)
+/// @return false if the write queue is full
+bool SETTINGS_WriteAsync(uint16_t address, void *data, uint8_t size)
+{
+  if (writeQueueCount == SETTINGS_WRITE_QUEUE_SIZE)
+  {
+    return false;
+  }
+
+  SettingsWriteJob_t *job = &writeQueue[(writeQueueHead + writeQueueCount) % SETTINGS_WRITE_QUEUE_SIZE];
+  job->address = address;
+  job->data = (uint8_t *)data;
+  job->words = size / EEPROM_ALIGNMENT;
+  writeQueueCount++;
+  return true;
+}
+
+/// @brief Check if there are pending asynchronous writes
+/// @return true if writes are pending
+bool SETTINGS_WriteBusy()
+{
+  return writeQueueCount > 0;
+}
+
+/// @brief Get amount of asynchronous writes that can still be queued
+/// @return free write queue slots
+uint8_t SETTINGS_WriteFree()
+{
+  return SETTINGS_WRITE_QUEUE_SIZE - writeQueueCount;
+}
+
+/// @brief Check if buffer is still referenced by a queued asynchronous write
+/// @param data source buffer
+/// @param size size in bytes
+/// @return true if the buffer must not be modified yet
+bool SETTINGS_WriteInProgress(void *data, uint8_t size)
+{
+  for (uint8_t i = 0; i < writeQueueCount; i++)
+  {
+    // job data pointer advances through the buffer until the job finishes
+    uint8_t *jobData = writeQueue[(writeQueueHead + i) % SETTINGS_WRITE_QUEUE_SIZE].data;
+    if (jobData >= (uint8_t *)data && jobData < (uint8_t *)data + size)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void SETTINGS_TimeSlice10ms()
+{
+  write_scheduler_10ms();
 }
 
 void SETTINGS_TimeSlice1000ms()
@@ -76,4 +165,27 @@ static void save_settings_scheduler_1000ms()
       SETTINGS_Save();
     }
   }
-}
\ No newline at end of file
+}
+
+// handler function for the asynchronous write queue
+static void write_scheduler_10ms()
+{
+  if (writeQueueCount == 0)
+  {
+    return;
+  }
+
+  SettingsWriteJob_t *job = &writeQueue[writeQueueHead];
+  // write single word per slice to keep the tick short
+  lgt_eeprom_writeSWM(job->address, (uint32_t *)job->data, 1);
+  job->address += EEPROM_ALIGNMENT;
+  job->data += EEPROM_ALIGNMENT;
+  job->words--;
+
+  // job finished - move onto the next one
+  if (job->words == 0)
+  {
+    writeQueueHead = (writeQueueHead + 1) % SETTINGS_WRITE_QUEUE_SIZE;
+    writeQueueCount--;
+  }
+}
@@ -23,6 +23,22 @@
 #define SETTINGS_SAVE_DELAY_SECONDS 10
 // EEPROM starting address
 #define EEPROM_ADDRESS 0
+// EEPROM address of tunable params (leaves room for the settings to grow)
+#define EEPROM_PARAMS_ADDRESS 64
+// EEPROM address of the fault log
+#define EEPROM_FAULT_LOG_ADDRESS 128
+// EEPROM address following the fault log
+#define EEPROM_FAULT_LOG_END_ADDRESS 320
+// EEPROM address of the energy log
+#define EEPROM_ENERGY_ADDRESS EEPROM_FAULT_LOG_END_ADDRESS
+// EEPROM address following the energy log
+#define EEPROM_ENERGY_END_ADDRESS 384
+// EEPROM address of the list mode program
+#define EEPROM_LIST_ADDRESS EEPROM_ENERGY_END_ADDRESS
+// EEPROM address following the list mode program
+#define EEPROM_LIST_END_ADDRESS 592
+// Amount of queued asynchronous EEPROM writes
+#define SETTINGS_WRITE_QUEUE_SIZE 4
 // EEPROM alignment
 #define EEPROM_ALIGNMENT 4
 
@@ -47,6 +63,7 @@ enum AppMode_t : uint8_t
     APP_MODE_MPPT,        // MPPT mode
     APP_MODE_ERROR,       // error mode
     APP_MODE_CALIBRATION, // calibration mode
+    APP_MODE_LIST,        // list mode (output sequence driven from the serial console)
     APP_MODE_MAX          // not used, needed for wraparound
 };
 typedef enum AppMode_t AppMode_t;
@@ -99,6 +116,14 @@ typedef struct
     CvModeVoltage_t voltage; // max voltage
 } ChargeModeSettings_t;
 
+// Asynchronous EEPROM write job
+typedef struct
+{
+    uint16_t address; // EEPROM address of the next word
+    uint8_t *data;    // next word to be written
+    uint8_t words;    // words left to write
+} SettingsWriteJob_t;
+
 // SETTINGS values
 typedef struct
 {
@@ -117,5 +142,12 @@ extern uint8_t gSettingsSaveIn1000ms;
 
 void SETTINGS_Load();
 void SETTINGS_Save();
+void SETTINGS_Read(uint16_t address, void *data, uint8_t size);
+void SETTINGS_Write(uint16_t address, void *data, uint8_t size);
+bool SETTINGS_WriteAsync(uint16_t address, void *data, uint8_t size);
+bool SETTINGS_WriteBusy();
+uint8_t SETTINGS_WriteFree();
+bool SETTINGS_WriteInProgress(void *data, uint8_t size);
+void SETTINGS_TimeSlice10ms();
 void SETTINGS_TimeSlice1000ms();
 #endif
\ No newline at end of file
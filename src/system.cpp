@@ -16,8 +16,12 @@
 
 #include <WDT.h>
 #include <lgt_LowPower.h>
+#include <util/atomic.h>
 
 #include "app.h"
+#include "console.h"
+#include "event.h"
+#include "power.h"
 #include "drivers/adc.h"
 #include "drivers/button.h"
 #include "drivers/led.h"
@@ -26,7 +30,6 @@
 #include "settings.h"
 
 // main timekeeping via timer
-volatile bool tick10ms = 0;
 volatile unsigned long timer2_10millis = 0;
 // time slice tick counters
 uint8_t slice10ms, slice100ms, slice500ms;
@@ -34,13 +37,16 @@ uint8_t slice10ms, slice100ms, slice500ms;
 static void watchdog_enable();
 static void system_clock_timer_enable();
 static void send_welcome_message();
+static void handle_event(const Event_t *event);
 
 // Interrupt handler when TIMER2 overflows (happens every 10.24ms)
 ISR(TIMER2_OVF_vect)
 {
-  // indicate that 10ms has passed
-  tick10ms = 1;
   timer2_10millis += 1;
+  // dim the fractional bar graph LED
+  LED_PwmOverflow();
+  // indicate that 10ms has passed
+  EVENT_PushFromISR(EVENT_TICK_10MS, timer2_10millis);
 }
 
 /// @brief Setup system
@@ -75,14 +81,15 @@ void SYSTEM_Tick()
   // Perform app logic every tick
   APP_Tick();
 
-  // Detect if 10ms has passed
-  if (tick10ms)
+  // Handle events queued by interrupt handlers in order
+  Event_t event;
+  while (EVENT_Pop(&event))
   {
-    // reset the indicator
-    tick10ms = 0;
-    // runs every 10ms
-    SYSTEM_TimeSlice10ms();
+    handle_event(&event);
   }
+
+  // Sleep until next tick if converter is idle
+  POWER_Tick();
 }
 
 void SYSTEM_TimeSlice10ms()
@@ -91,6 +98,9 @@ void SYSTEM_TimeSlice10ms()
   APP_TimeSlice10ms();
   LED_TimeSlice10ms();
   BUTTON_TimeSlice10ms();
+  CONSOLE_TimeSlice10ms();
+  SETTINGS_TimeSlice10ms();
+  POWER_TimeSlice10ms();
 
   // Propagate tick
   if (slice10ms < 10 - 1)
@@ -110,6 +120,7 @@ void SYSTEM_TimeSlice100ms()
   APP_TimeSlice100ms();
   LED_TimeSlice100ms();
   BUTTON_TimeSlice100ms();
+  PWM_TimeSlice100ms();
 
   // Propagate tick
   if (slice100ms < 5 - 1)
@@ -174,7 +185,14 @@ void SYSTEM_Reboot()
 /// @return how many 10ms passed since system started
 unsigned long SYSTEM_10millis()
 {
-  return timer2_10millis;
+  unsigned long time;
+
+  // multi-byte read must not be torn by TIMER2 overflow
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    time = timer2_10millis;
+  }
+  return time;
 }
 
 // Enable watchog
@@ -211,3 +229,17 @@ static void send_welcome_message()
 {
   Serial.println(F(SYSTEM_WELCOME_MESSAGE));
 }
+
+// Dispatch event from the queue
+static void handle_event(const Event_t *event)
+{
+  switch (event->type)
+  {
+  case EVENT_TICK_10MS:
+    // runs every 10ms
+    SYSTEM_TimeSlice10ms();
+    break;
+  default:
+    break;
+  }
+}
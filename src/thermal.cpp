@@ -0,0 +1,80 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#include "thermal.h"
+#include "app.h"
+#include "drivers/adc.h"
+#include "lib/filter.h"
+
+#ifdef TEMPERATURE_SENSOR
+// Local functions
+static uint8_t derating(int16_t temperature);
+
+static FilterIrrLp_t temperatureFilter;
+#endif
+
+/// @brief Setup temperature sensing
+void THERMAL_Setup()
+{
+  gApp.temperature = THERMAL_UNKNOWN;
+  gApp.derating = 100;
+#ifdef TEMPERATURE_SENSOR
+  FILTER_Init(&temperatureFilter, THERMAL_FILTER_ATT);
+  // start from the actual temperature instead of 0
+  temperatureFilter.current_val = ADC_TemperatureVal();
+#endif
+}
+
+/// @brief Sample temperature and update output current derating
+/// @return FAULT_CAUSE_OVER_TEMPERATURE if temperature is over THERMAL_SHUTDOWN, FAULT_CAUSE_NONE otherwise
+FaultCause_t THERMAL_TimeSlice100ms()
+{
+#ifdef TEMPERATURE_SENSOR
+  gApp.temperature = FILTER_Update(&temperatureFilter, ADC_TemperatureVal());
+  gApp.derating = derating(gApp.temperature);
+
+  if (gApp.temperature >= THERMAL_SHUTDOWN)
+  {
+    return FAULT_CAUSE_OVER_TEMPERATURE;
+  }
+#endif
+  return FAULT_CAUSE_NONE;
+}
+
+/// @brief Scale current limit by the thermal derating
+/// @param current current limit in mA
+/// @return derated current limit in mA
+uint32_t THERMAL_Derate(uint32_t current)
+{
+  return (current * gApp.derating) / 100;
+}
+
+#ifdef TEMPERATURE_SENSOR
+// Linear derating curve between THERMAL_DERATING_START and THERMAL_DERATING_END
+static uint8_t derating(int16_t temperature)
+{
+  if (temperature <= THERMAL_DERATING_START)
+  {
+    return 100;
+  }
+  if (temperature >= THERMAL_DERATING_END)
+  {
+    return THERMAL_DERATING_MIN;
+  }
+  return 100 - ((uint32_t)(temperature - THERMAL_DERATING_START) * (100 - THERMAL_DERATING_MIN)) /
+                   (THERMAL_DERATING_END - THERMAL_DERATING_START);
+}
+#endif
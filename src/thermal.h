@@ -0,0 +1,40 @@
+/* Copyright 2025 kamilsss655
+ * https://github.com/kamilsss655
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef THERMAL_H
+#define THERMAL_H
+
+#include <stdint.h>
+
+#include "fault_log.h"
+
+// Temperature in 0.1°C where output current derating starts
+#define THERMAL_DERATING_START 700 // 70°C
+// Temperature in 0.1°C where output current derating reaches THERMAL_DERATING_MIN
+#define THERMAL_DERATING_END 900 // 90°C
+// Minimum output current percentage (0-100%) at THERMAL_DERATING_END and above
+#define THERMAL_DERATING_MIN 20
+// Temperature in 0.1°C that trips the over-temperature protection
+#define THERMAL_SHUTDOWN 1000 // 100°C
+// Filter attenuation of temperature sampled every 100ms - the higher the value the lower the response time
+#define THERMAL_FILTER_ATT 7
+// Temperature reported when sensor is not fitted
+#define THERMAL_UNKNOWN INT16_MIN
+
+void THERMAL_Setup();
+FaultCause_t THERMAL_TimeSlice100ms();
+uint32_t THERMAL_Derate(uint32_t current);
+#endif